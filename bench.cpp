@@ -0,0 +1,282 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "board.h"
+#include "parser.h"
+#include "solver.h"
+
+// ================================================================
+// ================================================================
+// Times the solver on a corpus of puzzles (like the ones in the
+// benchmarks directory) and prints the results as JSON, so runs of
+// different builds can be compared.  Each puzzle is solved in each mode
+// several times, every run in its own child process so that its peak
+// memory can be measured on its own, and the median time is reported.
+
+bool usage(const std::string &executable_name) {
+  std::cerr << "Usage: " << executable_name << " [-runs <#>] [-timeout <seconds>] [-threads <#>]" << std::endl;
+  std::cerr << "       [-modes <default,all_solutions,accessibility>] <puzzle_file|directory> ..." << std::endl;
+  exit(1);
+}
+
+
+// the modes each puzzle is solved in, named as in the JSON output
+const char* const MODES[] = { "default", "all_solutions", "accessibility" };
+const int NUM_MODES = 3;
+
+// what one run of the solver reports back to the benchmark
+class RunRecord {
+public:
+  int moves;
+  unsigned long long solutions;
+  long long expanded;
+  double seconds;
+};
+
+// what the runs of one puzzle in one mode measured
+class Measurement {
+public:
+  Measurement() : moves(-1), solutions(0), expanded(0), peak_rss_kb(0), timed_out(false) {}
+  int moves;
+  unsigned long long solutions;
+  long long expanded;
+  std::vector<double> seconds;
+  long peak_rss_kb;
+  bool timed_out;
+};
+
+
+// ================================================================
+// ================================================================
+// the puzzle files named on the command line, with each directory
+// replaced by the files in it (in alphabetical order)
+std::vector<std::string> puzzleFiles(const std::vector<std::string> &args) {
+  std::vector<std::string> files;
+  for (unsigned int i = 0; i < args.size(); i++) {
+    DIR *dir = opendir(args[i].c_str());
+    if (dir == NULL) {
+      files.push_back(args[i]);
+      continue;
+    }
+    std::vector<std::string> entries;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      std::string name = entry->d_name;
+      if (name[0] == '.') continue;
+      entries.push_back(args[i] + "/" + name);
+    }
+    closedir(dir);
+    std::sort(entries.begin(),entries.end());
+    files.insert(files.end(),entries.begin(),entries.end());
+  }
+  return files;
+}
+
+// a string as a JSON string literal
+std::string quoted(const std::string &s) {
+  std::string out = "\"";
+  for (unsigned int i = 0; i < s.size(); i++) {
+    if (s[i] == '"' || s[i] == '\\') out += '\\';
+    out += s[i];
+  }
+  return out + "\"";
+}
+
+
+// ================================================================
+// ================================================================
+// Solve the board once in a child process, which is killed if it takes
+// longer than timeout seconds (0 for no limit).  Returns false if the
+// run didn't finish, and otherwise fills in the record and the peak
+// resident memory of the child.
+bool timedRun(const Board &board, const SolverOptions &options, int timeout,
+              RunRecord &record, long &peak_rss_kb) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::cerr << "ERROR: could not create a pipe" << std::endl;
+    exit(1);
+  }
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid < 0) {
+    std::cerr << "ERROR: could not start a child process" << std::endl;
+    exit(1);
+  }
+
+  if (pid == 0) {
+    // the child solves the puzzle and writes its record to the pipe
+    close(fds[0]);
+    if (timeout > 0) alarm(timeout);
+    Solver solver;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    SolverResult result = solver.solve(board,options);
+    RunRecord r;
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    r.moves = result.moves;
+    r.solutions = result.solutions;
+    r.expanded = result.expanded;
+    bool ok = write(fds[1],&r,sizeof(r)) == (ssize_t)sizeof(r);
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  bool ok = read(fds[0],&record,sizeof(record)) == (ssize_t)sizeof(record);
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  wait4(pid,&status,0,&usage);
+  // ru_maxrss is in kilobytes on Linux
+  peak_rss_kb = usage.ru_maxrss;
+  return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Run the solver on a board in one mode the given number of times,
+// stopping at the first run that times out
+Measurement measure(const Board &board, const std::string &mode, int runs,
+                    int timeout, int threads) {
+  SolverOptions options;
+  options.threads = threads;
+  if (mode == "all_solutions") {
+    // the solutions are passed on as they are found (like the program
+    // prints them), rather than all kept in memory
+    options.all_solutions = true;
+    options.on_solution = [](const MovePath &, unsigned long long) {};
+  } else if (mode == "accessibility") {
+    options.accessibility = true;
+  }
+
+  Measurement m;
+  for (int i = 0; i < runs; i++) {
+    RunRecord record;
+    long rss;
+    if (!timedRun(board,options,timeout,record,rss)) {
+      m.timed_out = true;
+      break;
+    }
+    m.moves = record.moves;
+    m.solutions = record.solutions;
+    m.expanded = record.expanded;
+    m.seconds.push_back(record.seconds);
+    m.peak_rss_kb = std::max(m.peak_rss_kb,rss);
+  }
+  return m;
+}
+
+void printMeasurement(const std::string &file, const Board &board, const std::string &mode,
+                      const Measurement &m) {
+  std::vector<double> seconds = m.seconds;
+  std::sort(seconds.begin(),seconds.end());
+  double median = 0;
+  if (!seconds.empty()) {
+    unsigned int half = seconds.size() / 2;
+    median = seconds.size() % 2 ? seconds[half] : (seconds[half-1] + seconds[half]) / 2;
+  }
+
+  std::cout << "    { \"puzzle\": " << quoted(file)
+            << ", \"rows\": " << board.getRows()
+            << ", \"cols\": " << board.getCols()
+            << ", \"robots\": " << board.numRobots()
+            << ", \"mode\": " << quoted(mode)
+            << ", \"runs\": " << seconds.size()
+            << ", \"timed_out\": " << (m.timed_out ? "true" : "false");
+  if (!seconds.empty()) {
+    std::cout << std::fixed << std::setprecision(6)
+              << ", \"median_seconds\": " << median
+              << std::setprecision(0)
+              << ", \"states_per_second\": " << (median > 0 ? m.expanded / median : 0)
+              << ", \"expanded\": " << m.expanded
+              << ", \"peak_rss_kb\": " << m.peak_rss_kb;
+    if (mode != "accessibility") {
+      std::cout << ", \"moves\": " << m.moves
+                << ", \"solutions\": " << m.solutions;
+    }
+  }
+  std::cout << " }";
+}
+
+
+// ================================================================
+// ================================================================
+
+int main(int argc, char* argv[]) {
+  int runs = 5;
+  int timeout = 60;
+  int threads = 1;
+  std::vector<std::string> modes(MODES,MODES+NUM_MODES);
+  std::vector<std::string> args;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i] == std::string("-runs")) {
+      i++;
+      if (i >= argc) usage(argv[0]);
+      runs = atoi(argv[i]);
+      if (runs < 1) usage(argv[0]);
+    } else if (argv[i] == std::string("-timeout")) {
+      i++;
+      if (i >= argc) usage(argv[0]);
+      timeout = atoi(argv[i]);
+      if (timeout < 0) usage(argv[0]);
+    } else if (argv[i] == std::string("-threads")) {
+      i++;
+      if (i >= argc) usage(argv[0]);
+      threads = atoi(argv[i]);
+      if (threads < 1) usage(argv[0]);
+    } else if (argv[i] == std::string("-modes")) {
+      i++;
+      if (i >= argc) usage(argv[0]);
+      modes.clear();
+      std::istringstream list(argv[i]);
+      std::string mode;
+      while (std::getline(list,mode,',')) {
+        if (std::find(MODES,MODES+NUM_MODES,mode) == MODES+NUM_MODES) {
+          std::cerr << "ERROR: unknown mode " << mode << std::endl;
+          usage(argv[0]);
+        }
+        modes.push_back(mode);
+      }
+      if (modes.empty()) usage(argv[0]);
+    } else if (argv[i][0] == '-') {
+      std::cerr << "ERROR: unknown argument " << argv[i] << std::endl;
+      usage(argv[0]);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  if (args.empty()) usage(argv[0]);
+  std::vector<std::string> files = puzzleFiles(args);
+
+  std::cout << "{" << std::endl;
+  std::cout << "  \"runs\": " << runs << "," << std::endl;
+  std::cout << "  \"timeout\": " << timeout << "," << std::endl;
+  std::cout << "  \"threads\": " << threads << "," << std::endl;
+  std::cout << "  \"results\": [" << std::endl;
+  bool first = true;
+  for (unsigned int i = 0; i < files.size(); i++) {
+    Board board(1,1);
+    std::string error;
+    if (!loadPuzzle(files[i],board,error)) {
+      std::cerr << "ERROR: " << error << std::endl;
+      exit(1);
+    }
+    board.computeSlideStops();
+    for (unsigned int j = 0; j < modes.size(); j++) {
+      Measurement m = measure(board,modes[j],runs,timeout,threads);
+      if (!first) std::cout << "," << std::endl;
+      first = false;
+      printMeasurement(files[i],board,modes[j],m);
+    }
+  }
+  std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+  return 0;
+}
@@ -1,8 +1,11 @@
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <cstring>
+#include <new>
 #include <stdlib.h> 
 #include "board.h"
+#include "state.h"
 
 
 // ==================================================================
@@ -26,6 +29,37 @@ bool operator!=(const Position &a, const Position &b) {
 }
 
 
+// ==================================================================
+// ==================================================================
+// Implementation of the AlignedBlock class
+
+AlignedBlock::AlignedBlock(size_t size) : data(NULL), bytes(size) {
+  if (bytes == 0) return;
+  void *memory;
+  if (posix_memalign(&memory,ALIGNMENT,roundUp(bytes)) != 0) throw std::bad_alloc();
+  data = (char*)memory;
+}
+
+AlignedBlock::AlignedBlock(const AlignedBlock &other) : AlignedBlock(other.bytes) {
+  if (bytes > 0) memcpy(data,other.data,bytes);
+}
+
+AlignedBlock& AlignedBlock::operator=(const AlignedBlock &other) {
+  if (this != &other) *this = AlignedBlock(other);
+  return *this;
+}
+
+AlignedBlock& AlignedBlock::operator=(AlignedBlock &&other) {
+  std::swap(data,other.data);
+  std::swap(bytes,other.bytes);
+  return *this;
+}
+
+AlignedBlock::~AlignedBlock() {
+  free(data);
+}
+
+
 // ==================================================================
 // ==================================================================
 // Implementation of the Board class
@@ -39,24 +73,33 @@ Board::Board(int r, int c) {
   // initialize the dimensions
   rows = r; 
   cols = c; 
-
-  // allocate space for the contents of each grid cell
-  board = std::vector<std::vector<char> >(rows,std::vector<char>(cols,' '));
-
-  // allocate space for booleans indicating the presense of each wall
-  // by default, these are false == no wall
-  // (note that there must be an extra column of vertical walls
-  //  and an extra row of horizontal walls)
-  vertical_walls = std::vector<std::vector<bool> >(rows,std::vector<bool>(cols+1,false));
-  horizontal_walls = std::vector<std::vector<bool> >(rows+1,std::vector<bool>(cols,false));
+  assert (rows >= 1 && cols >= 1 && (long long)rows*cols <= MAX_CELLS);
+
+  // lay out the block: the contents of each grid cell, then booleans
+  // indicating the presense of each wall (note that there must be an
+  // extra column of vertical walls and an extra row of horizontal
+  // walls), then the slide stops
+  stride = (cols + 7) & ~7;
+  num_edges = (rows+1)*cols + rows*(cols+1);
+  walls_offset = AlignedBlock::roundUp(size_t(rows)*stride);
+  stops_offset = walls_offset + AlignedBlock::roundUp(num_edges);
+  storage = AlignedBlock(stops_offset + size_t(rows)*cols*4*sizeof(int));
+  has_slide_stops = false;
+
+  // the cells start out empty, and by default there are no walls
+  memset(cells(),' ',size_t(rows)*stride);
+  memset(walls(),0,num_edges);
 
   // initialize the outermost edges of the grid to have walls
-  for (int i = 0; i < rows; i++) {
-    vertical_walls[i][0] = vertical_walls[i][cols] = true;
+  for (int i = 1; i <= rows; i++) {
+    walls()[verticalEdge(i,1)] = walls()[verticalEdge(i,2*cols+1)] = 1;
   }
-  for (int i = 0; i < cols; i++) {
-    horizontal_walls[0][i] = horizontal_walls[rows][i] = true;
+  for (int i = 1; i <= cols; i++) {
+    walls()[horizontalEdge(1,i)] = walls()[horizontalEdge(2*rows+1,i)] = 1;
   }
+
+  num_robots = 0;
+  goal_robot = -1;
 }
 
 
@@ -64,26 +107,21 @@ Board::Board(int r, int c) {
 // ACCESSORS related to board geometry
 // ===================
 
+// a wall coordinate (a whole number plus one half) in half units
+static int halfUnits(double x) {
+  // the coordinate must be a half unit
+  assert (fabs((x - floor(x))-0.5) < 0.005);
+  return int(floor(x))*2 + 1;
+}
+
 // Query the existance of a horizontal wall
 bool Board::getHorizontalWall(double r, int c) const {
-  // verify that the requested wall is valid
-  // the row coordinate must be a half unit
-  assert (fabs((r - floor(r))-0.5) < 0.005);
-  assert (r >= 0.4 && r <= rows+0.6);
-  assert (c >= 1 && c <= cols);
-  // subtract one and round down because the corner is (0,0) not (1,1)
-  return horizontal_walls[floor(r)][c-1];
+  return hasWall(horizontalEdge(halfUnits(r),c));
 }
 
 // Query the existance of a vertical wall
 bool Board::getVerticalWall(int r, double c) const {
-  // verify that the requested wall is valid
-  // the column coordinate must be a half unit
-  assert (fabs((c - floor(c))-0.5) < 0.005);
-  assert (r >= 1 && r <= rows);
-  assert (c >= 0.4 && c <= cols+0.6);
-  // subtract one and round down because the corner is (0,0) not (1,1)
-  return vertical_walls[r-1][floor(c)];
+  return hasWall(verticalEdge(r,halfUnits(c)));
 }
 
 
@@ -91,30 +129,14 @@ bool Board::getVerticalWall(int r, double c) const {
 // MODIFIERS related to board geometry
 // ===================
 
-// Add an interior horizontal wall
-void Board::addHorizontalWall(double r, int c) {
-  // verify that the requested wall is valid
-  // the row coordinate must be a half unit
-  assert (fabs((r - floor(r))-0.5) < 0.005);
-  assert (r >= 0 && r <= rows);
-  assert (c >= 1 && c <= cols);
+// Add an interior wall
+void Board::addWall(int edge) {
+  assert (edge >= 0 && edge < num_edges);
   // verify that the wall does not already exist
-  assert (horizontal_walls[floor(r)][c-1] == false);
-  // subtract one and round down because the corner is (0,0) not (1,1)
-  horizontal_walls[floor(r)][c-1] = true;
-}
-
-// Add an interior vertical wall
-void Board::addVerticalWall(int r, double c) {
-  // verify that the requested wall is valid
-  // the column coordinate must be a half unit
-  assert (fabs((c - floor(c))-0.5) < 0.005);
-  assert (r >= 1 && r <= rows);
-  assert (c >= 0 && c <= cols);
-  // verify that the wall does not already exist
-  assert (vertical_walls[r-1][floor(c)] == false);
-  // subtract one and round down because the corner is (0,0) not (1,1)
-  vertical_walls[r-1][floor(c)] = true;
+  assert (walls()[edge] == 0);
+  walls()[edge] = 1;
+  // the slide table no longer matches the walls
+  has_slide_stops = false;
 }
 
 
@@ -127,7 +149,7 @@ char Board::getspot(const Position &p) const {
   assert (p.row >= 1 && p.row <= rows);
   assert (p.col >= 1 && p.col <= cols);
   // subtract one from each coordinate because the corner is (0,0) not (1,1)
-  return board[p.row-1][p.col-1];
+  return cells()[(p.row-1)*stride + p.col-1];
 }
 
 void Board::setspot(const Position &p, char a) {
@@ -135,7 +157,7 @@ void Board::setspot(const Position &p, char a) {
   assert (p.row >= 1 && p.row <=  rows);
   assert (p.col >= 1 && p.col <= cols);
   // subtract one from each coordinate because the corner is (0,0) not (1,1)
-  board[p.row-1][p.col-1] = a;
+  cells()[(p.row-1)*stride + p.col-1] = a;
 }
 
 
@@ -146,7 +168,7 @@ void Board::setspot(const Position &p, char a) {
 
 // Given a robot name, find the id of that robot
 int Board::whichRobot(char a) const {
-  for (unsigned int i = 0; i < robots.size(); i++) {
+  for (int i = 0; i < num_robots; i++) {
     if (robots[i] == a) {
       return i;
     }
@@ -175,302 +197,171 @@ void Board::placeRobot(const Position &p, char a) {
   assert (a >= 'A' && a <= 'Z');
 
   // make sure we don't already have a robot with the same name
-  for (unsigned int i = 0; i < robots.size(); i++) {
+  for (int i = 0; i < num_robots; i++) {
     assert (robots[i] != a);
   }
 
-  // add the robot and its position to the vectors of robots
-  robots.push_back(a);
-  robot_positions.push_back(p);
+  // add the robot and its position to the arrays of robots
+  assert (num_robots < MAX_ROBOTS);
+  robots[num_robots] = a;
+  robot_positions[num_robots] = p;
+  num_robots++;
 
   // mark the robot on the board
   setspot(p,a);
 }
-/*$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$ My Code Starts HERE $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$*/
-void Board::trackMoves(int i, std::vector<Position> pos, int c, std::vector<std::string> path)  //Ok... so my recursion is a little weird but its not that hard to understand.
-{																							//Think of it as a three step process... we add robot moves to the vectors and check for... 
-	c++;																					//...completion.  Then if we are not complete, we send that information to a function that...
-	if (mm == -1)																			//...cycles through all the moves and all the robots.  And lastly we have function that moves...
-	{																						//...the robots and calls the first function to add the moves to the vectors again.
-		mm = 14;
-	}
-	int h = path.size()/2;
-	bool check = false;
-	for (int j = 0; j < path.size()/2; j++)
-	{
-		if (path[j] != path[j+h])
-		{
-			check = true;
-		}
-	}	
-	if (check = false && path.size() > 7)
-	{
-		return;
-	}
-	if (c == 1) //If it is the first time running through we don't need to add anything
-	{
-		cycleMoves(pos, c, path); //Just send it straight to the cycle
-		return;
-	}
-	if (pos.empty() == false) //Otherwise we check if the vector of robot positions returned is empty (this is how I check if the robot got moved)
-	{
-		if ((c-1) < viz[pos[i].row][pos[i].col] || viz[pos[i].row][pos[i].col] == -1) //If it was, and if it reached the spot it moved it in less moves than any other robot
-		{																		//Or it is the first robot to reach that spot
-			viz[pos[i].row][pos[i].col] = (c-1); //Then we add it to the visualization vector
-		}
-	}
-	else //Otherwise that path is dead
-	{
-		return;
-	}
-	for (int j = 0; j < numRobots(); j++)
-	{
-		if (pos[j].col == getGoal().col && pos[j].row == getGoal().row) //Here we check if a robot has reached the goal
-		{ 
-			if (goal_robot == -1 || i == goal_robot)  //and if the robot that reached the goal matters, and if so... if its correct
-			{
-				if ((c-1) < mm) //If those are true... and the robot reached the goal in a number of moves less than any other path before
-				{
-					mm = (c-1); 
-					paths.clear(); //We clear the path
-				}
-				paths.push_back(path);	//But no matter what we add the new path to the paths 
-			}
-		}
-	}
-	if (c > mm && mm != -1) //Here we check for completion
-	{
-		return;
-	}
-	else if (c == 14)
-	{
-		return;
-	}
-	else
-	{
-		cycleMoves(pos, c, path); //If we aren't complete we go to step 2
-	}
+
+
+// ===================
+// MOVING ROBOTS
+// ===================
+
+// the names of the directions, in the order the solver tries them
+std::string directionName(int direction) {
+  static const char* names[4] = { "north", "south", "east", "west" };
+  assert (direction >= NORTH && direction <= WEST);
+  return names[direction];
+}
+
+// For every cell and direction, find where a robot starting in that
+// cell would stop if there were no other robots on the board.  This
+// only depends on the walls, so it is done once after the board is
+// loaded (adding a wall throws the table away).  Boards of up to 16x16
+// cells also get the walls as bitboards, see slideBits.
+void Board::computeSlideStops() {
+  if (hasBitboards()) {
+    std::fill(north_walls,north_walls+16,0);
+    std::fill(south_walls,south_walls+16,0);
+    std::fill(east_walls,east_walls+16,0);
+    std::fill(west_walls,west_walls+16,0);
+    for (int r = 1; r <= rows; r++) {
+      for (int c = 1; c <= cols; c++) {
+        if (hasWall(cellEdge(r,c,NORTH))) north_walls[c-1] |= 1 << (r-1);
+        if (hasWall(cellEdge(r,c,SOUTH))) south_walls[c-1] |= 1 << (r-1);
+        if (hasWall(cellEdge(r,c,EAST))) east_walls[r-1] |= 1 << (c-1);
+        if (hasWall(cellEdge(r,c,WEST))) west_walls[r-1] |= 1 << (c-1);
+      }
+    }
+  }
+  int *slide_stops = slideStops();
+  for (int r = 1; r <= rows; r++) {
+    for (int c = 1; c <= cols; c++) {
+      int cell = (r-1)*cols + c-1;
+      int i;
+      for (i = r; !hasWall(cellEdge(i,c,NORTH)); i--) {}
+      slide_stops[cell*4+NORTH] = (i-1)*cols + c-1;
+      for (i = r; !hasWall(cellEdge(i,c,SOUTH)); i++) {}
+      slide_stops[cell*4+SOUTH] = (i-1)*cols + c-1;
+      for (i = c; !hasWall(cellEdge(r,i,EAST)); i++) {}
+      slide_stops[cell*4+EAST] = (r-1)*cols + i-1;
+      for (i = c; !hasWall(cellEdge(r,i,WEST)); i--) {}
+      slide_stops[cell*4+WEST] = (r-1)*cols + i-1;
+    }
+  }
+  has_slide_stops = true;
+}
+
+// Slide robot i in the given direction until it hits a wall or another
+// robot.  The wall stop comes from the precomputed table, then it is
+// pulled back in front of the nearest robot lying on the way there.
+// Returns false (and leaves the positions unchanged) if the robot is
+// blocked right away and cannot move at all.
+bool Board::moveRobot(std::vector<Position> &pos, int i, int direction) const {
+  // computeSlideStops must be called once the walls are in place
+  assert (has_slide_stops);
+  Position p = pos[i];
+  int stop = slideStop((p.row-1)*cols + p.col-1, direction);
+  int stop_row = stop / cols + 1;
+  int stop_col = stop % cols + 1;
+  for (unsigned int j = 0; j < pos.size(); j++) {
+    const Position &q = pos[j];
+    if (direction == NORTH) {
+      if (q.col == p.col && q.row < p.row && q.row >= stop_row) stop_row = q.row+1;
+    } else if (direction == SOUTH) {
+      if (q.col == p.col && q.row > p.row && q.row <= stop_row) stop_row = q.row-1;
+    } else if (direction == EAST) {
+      if (q.row == p.row && q.col > p.col && q.col <= stop_col) stop_col = q.col-1;
+    } else {
+      if (q.row == p.row && q.col < p.col && q.col >= stop_col) stop_col = q.col+1;
+    }
+  }
+  if (stop_row == p.row && stop_col == p.col) return false;
+  pos[i] = Position(stop_row,stop_col);
+  return true;
 }
 
-void Board::cycleMoves(std::vector<Position> pos, int c, std::vector<std::string> path)
-{
-  for (int i = 0; i < numRobots(); i++) //Step 2 is simple... just keep sending robots through the spin cycle aka the moveRobot function
-  {
-	moveRobot(i, "north", 0, pos, c, path);
-	moveRobot(i, "south", 0, pos, c, path);
-	moveRobot(i, "east", 0, pos, c, path);
-	moveRobot(i, "west", 0, pos, c, path);
+// Mark the robots in the row and column occupancy masks
+void Board::fillOccupancy(const std::vector<Position> &pos, Occupancy &occ) const {
+  for (int r = 0; r < rows; r++) occ.row_bits[r] = 0;
+  for (int c = 0; c < cols; c++) occ.col_bits[c] = 0;
+  for (unsigned int j = 0; j < pos.size(); j++) {
+    occ.row_bits[pos[j].row-1] |= 1 << (pos[j].col-1);
+    occ.col_bits[pos[j].col-1] |= 1 << (pos[j].row-1);
   }
 }
 
-void Board::moveRobot(int i, const std::string &direction, int m, std::vector<Position> pos,  int c, std::vector<std::string> path) {
-if (direction == "north") //If we are moving a robot north
-{
-	for (int j = 0; j < pos.size(); j++) //For every robot
-	{
-		if (pos[i].row-1 == pos[j].row && pos[i].col == pos[j].col) //We have to make sure that no robots are above the one being moved
-		{
-			if (m == 0) //If there is and we didn't move at all
-			{
-				return; //We can't move and return
-			}
-			if (mm == -2) //If we are just trying to set the map for display (in a one requested path scenario) then we set the path and return
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-			std::string z = "robot x moves north"; //But usually if a robot is above, then we have reached a new destination
-			z[6] = getRobot(i); //We add the robot moved to the magic z string
-			path.push_back(z); //And pushback that string into the path
-			trackMoves(i, pos, c, path); //Then return to track moves!
-			return;
-		}
-	}
-	if (getHorizontalWall(double(pos[i].row - .5), pos[i].col) == true) //If there wasn't another robot above... there could still be a wall
-	{
-			if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-		
-			std::string z = "robot x moves north"; //Same deal... just if there is a wall there
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-	}
-	else
-	{
-		pos[i].row--; //Otherwise we can move the robot
-		moveRobot(i, direction, 1, pos, c, path); //And we recurse by sending the robot through the move again
-	}
+// Where a robot at p stops sliding, using the bitboards.  The walls in
+// the direction of travel are combined with the robots shifted back by
+// one cell (a robot stops in front of another robot), and the stop is
+// the nearest set bit past the robot, found with a count of the
+// leading or trailing zeros.  The robot's own bit is shifted out of the
+// way, so it doesn't need to be removed from the occupancy first.
+Position Board::slideBits(const Occupancy &occ, const Position &p, int direction) const {
+  unsigned int r = p.row-1;
+  unsigned int c = p.col-1;
+  unsigned int m;
+  if (direction == NORTH) {
+    m = (north_walls[c] | (occ.col_bits[c] << 1)) & ((2u << r) - 1);
+    return Position(32 - __builtin_clz(m), p.col);
+  } else if (direction == SOUTH) {
+    m = (south_walls[c] | (occ.col_bits[c] >> 1)) & ~((1u << r) - 1);
+    return Position(__builtin_ctz(m) + 1, p.col);
+  } else if (direction == EAST) {
+    m = (east_walls[r] | (occ.row_bits[r] >> 1)) & ~((1u << c) - 1);
+    return Position(p.row, __builtin_ctz(m) + 1);
+  } else {
+    m = (west_walls[r] | (occ.row_bits[r] << 1)) & ((2u << c) - 1);
+    return Position(p.row, 32 - __builtin_clz(m));
+  }
 }
 
-if (direction == "south") //Same thing happens for the other directions... you can scroll down but there's nothing else down there to see
-{
-	for (int j = 0; j < pos.size(); j++)
-	{
-		if (1+pos[i].row == pos[j].row && pos[i].col == pos[j].col)
-		{
-						if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves south";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-		}
-	}
-	if (getHorizontalWall(double(pos[i].row + .5), pos[i].col) == true)
-	{
-						if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves south";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-	}
-	else
-	{
-		pos[i].row++;
-		moveRobot(i, direction, 1, pos, c, path);
-	}
+uint64_t Board::geometryHash() const {
+  assert (has_slide_stops);
+  std::vector<uint64_t> layout;
+  layout.push_back(rows);
+  layout.push_back(cols);
+  layout.push_back(goal.row);
+  layout.push_back(goal.col);
+  layout.insert(layout.end(), slideStops(), slideStops() + rows*cols*4);
+  return hashState(&layout[0],layout.size());
 }
 
-if (direction == "east")
-{
-	for (int j = 0; j < pos.size(); j++)
-	{
-		if (1+pos[i].col == pos[j].col && pos[i].row == pos[j].row)
-		{
-			if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves east";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-		}
-	}
-	if (getVerticalWall(pos[i].row, double(pos[i].col + .5)) == true)
-	{
-			if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves east";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-	}
-	else
-	{
-		pos[i].col++;
-		moveRobot(i, direction, 1, pos, c, path);
-	}
+uint64_t Board::wallHash() const {
+  std::vector<uint64_t> layout;
+  layout.push_back(rows);
+  layout.push_back(cols);
+  uint64_t bits = 0;
+  for (int e = 0; e < num_edges; e++) {
+    bits = (bits << 1) | walls()[e];
+    if (e % 64 == 63) layout.push_back(bits);
+  }
+  layout.push_back(bits);
+  return hashState(&layout[0],layout.size());
 }
 
-if (direction == "west")
-{
-	for (int j = 0; j < pos.size(); j++)
-	{
-		if (pos[i].col-1 == pos[j].col && pos[i].row == pos[j].row)
-		{
-						if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves west";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-		}
-	}
-	if (getVerticalWall(pos[i].row, double(pos[i].col - .5)) == true)
-	{
-						if (m == 0)
-			{
-				return;
-			}
-			if (mm == -2)
-			{
-				tempos.col = pos[i].col;
-				tempos.row = pos[i].row;
-				setspot(tempos, getRobot(i));
-				return;
-			}
-
-			std::string z = "robot x moves west";
-			z[6] = getRobot(i);
-			path.push_back(z);
-			trackMoves(i, pos, c, path);
-			return;
-	}
-	else
-	{
-		pos[i].col--;
-		moveRobot(i, direction, 1, pos, c, path);
-	}
+bool Board::sameWalls(const Board &other) const {
+  return rows == other.rows && cols == other.cols &&
+    memcmp(walls(),other.walls(),num_edges) == 0;
 }
 
+void Board::copySlideStops(const Board &other) {
+  assert (sameWalls(other) && other.has_slide_stops);
+  memcpy(slideStops(),other.slideStops(),size_t(rows)*cols*4*sizeof(int));
+  memcpy(north_walls,other.north_walls,sizeof(north_walls));
+  memcpy(south_walls,other.south_walls,sizeof(south_walls));
+  memcpy(east_walls,other.east_walls,sizeof(east_walls));
+  memcpy(west_walls,other.west_walls,sizeof(west_walls));
+  has_slide_stops = true;
 }
 
 
@@ -567,5 +458,46 @@ void Board::print() {
   }
 }
 
+// ==================================================================
+// WRITE A PUZZLE
+// ==================================================================
+
+std::string pathText(const Board &board, const MovePath &path) {
+  std::string text;
+  for (unsigned int j = 0; j < path.size(); j++) {
+    if (j != 0) text += ",";
+    text += board.getRobot(moveRobotId(path[j]));
+    text += directionName(moveDirection(path[j]))[0];
+  }
+  return text;
+}
+
+// the inverse of parsePuzzle: the dimensions, then the robots, the
+// interior walls and the goal
+void writePuzzle(std::ostream &ostr, const Board &board) {
+  int rows = board.getRows();
+  int cols = board.getCols();
+  ostr << rows << " " << cols << std::endl;
+  std::vector<Position> pos = board.getRobotPositions();
+  for (unsigned int i = 0; i < pos.size(); i++) {
+    ostr << "robot " << board.getRobot(i) << " " << pos[i].row << " " << pos[i].col << std::endl;
+  }
+  for (int r = 1; r <= rows; r++) {
+    for (int c = 1; c < cols; c++) {
+      if (board.hasWall(board.verticalEdge(r,2*c+1))) ostr << "vertical_wall " << r << " " << c << ".5" << std::endl;
+    }
+  }
+  for (int r = 1; r < rows; r++) {
+    for (int c = 1; c <= cols; c++) {
+      if (board.hasWall(board.horizontalEdge(2*r+1,c))) ostr << "horizontal_wall " << r << ".5 " << c << std::endl;
+    }
+  }
+  Position goal = board.getGoal();
+  ostr << "goal ";
+  if (board.getGoalRobot() == -1) ostr << "any";
+  else ostr << board.getRobot(board.getGoalRobot());
+  ostr << " " << goal.row << " " << goal.col << std::endl;
+}
+
 // ==================================================================
 // ==================================================================
@@ -1,8 +1,14 @@
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
 #include <cassert>
 #include <cmath>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
 
 
 // ==================================================================
@@ -22,6 +28,139 @@ bool operator==(const Position &a, const Position &b);
 bool operator!=(const Position &a, const Position &b);
 
 
+// the four directions a robot can be moved, in the order the solver
+// tries them
+enum Direction { NORTH = 0, SOUTH = 1, EAST = 2, WEST = 3 };
+std::string directionName(int direction);
+
+
+// ==================================================================
+// ==================================================================
+// A single move packed into one byte, the robot id times 4 plus the
+// direction (there are at most 26 robots)
+
+typedef unsigned char Move;
+inline Move makeMove(int robot, int direction) { return robot*4 + direction; }
+inline int moveRobotId(Move m) { return m / 4; }
+inline int moveDirection(Move m) { return m % 4; }
+
+
+// ==================================================================
+// ==================================================================
+// A sequence of moves.  The first CAPACITY moves are stored inline in
+// a fixed size array, so recording and copying the paths of almost
+// every puzzle never allocates memory; a longer path keeps the rest of
+// its moves in a vector.
+
+class MovePath {
+public:
+  // the moves held inline
+  static const int CAPACITY = 63;
+
+  MovePath() : length(0) {}
+
+  unsigned int size() const { return length; }
+  bool empty() const { return length == 0; }
+  Move operator[](unsigned int i) const {
+    assert (i < length);
+    return (i < (unsigned int)CAPACITY) ? moves[i] : overflow[i-CAPACITY];
+  }
+  Move back() const { assert (length > 0); return (*this)[length-1]; }
+
+  void push_back(Move m) {
+    if (length < (unsigned int)CAPACITY) moves[length] = m;
+    else overflow.push_back(m);
+    length++;
+  }
+  void pop_back() {
+    assert (length > 0);
+    length--;
+    if (length >= (unsigned int)CAPACITY) overflow.pop_back();
+  }
+
+private:
+  unsigned int length;
+  Move moves[CAPACITY];
+  // the moves past CAPACITY
+  std::vector<Move> overflow;
+};
+
+
+// ==================================================================
+// ==================================================================
+// The robot positions as bitboards, for boards of up to 16x16 cells:
+// bit c-1 of row_bits[r-1] (and bit r-1 of col_bits[c-1]) is set if
+// there is a robot in cell (r,c)
+
+class Occupancy {
+public:
+  unsigned short row_bits[16];
+  unsigned short col_bits[16];
+};
+
+
+// ==================================================================
+// ==================================================================
+// A block of memory aligned to a cache line, for the flat arrays below.
+// Copying one is a single allocation and memcpy.
+
+class AlignedBlock {
+public:
+  static const size_t ALIGNMENT = 64;
+  // a size rounded up to a whole number of cache lines
+  static size_t roundUp(size_t bytes) { return (bytes + ALIGNMENT-1) & ~(ALIGNMENT-1); }
+
+  AlignedBlock() : data(NULL), bytes(0) {}
+  explicit AlignedBlock(size_t size);
+  AlignedBlock(const AlignedBlock &other);
+  AlignedBlock(AlignedBlock &&other) : data(other.data), bytes(other.bytes) {
+    other.data = NULL;
+    other.bytes = 0;
+  }
+  AlignedBlock& operator=(const AlignedBlock &other);
+  AlignedBlock& operator=(AlignedBlock &&other);
+  ~AlignedBlock();
+
+  char* get() { return data; }
+  const char* get() const { return data; }
+  size_t size() const { return bytes; }
+
+private:
+  char *data;
+  size_t bytes;
+};
+
+
+// ==================================================================
+// ==================================================================
+// A rectangle of values (of a type that can be copied with memcpy)
+// stored row by row in one flat, cache line aligned array, indexed as
+// grid[row][col]
+
+template <class T>
+class Grid {
+public:
+  Grid() : rows(0), cols(0) {}
+  Grid(int num_rows, int num_cols, const T &value)
+    : rows(num_rows), cols(num_cols), storage(sizeof(T)*num_rows*num_cols) {
+    std::fill(cells(), cells() + rows*cols, value);
+  }
+
+  int numRows() const { return rows; }
+  int numCols() const { return cols; }
+  T* operator[](int r) { return cells() + r*cols; }
+  const T* operator[](int r) const { return cells() + r*cols; }
+
+private:
+  T* cells() { return (T*)storage.get(); }
+  const T* cells() const { return (const T*)storage.get(); }
+
+  int rows;
+  int cols;
+  AlignedBlock storage;
+};
+
+
 // ==================================================================
 // ==================================================================
 // A class to hold information about the puzzle board including the
@@ -39,17 +178,44 @@ public:
   // ACCESSORS related the board geometry
   int getRows() const { return rows; }
   int getCols() const { return cols; }
+  // the walls by their edge index (see below)
+  bool hasWall(int edge) const { return walls()[edge]; }
+  // the walls in the coordinates of the puzzle file, where the row of a
+  // horizontal wall (and the column of a vertical one) is half way
+  // between two cells, like 2.5
   bool getHorizontalWall(double r, int c) const;
   bool getVerticalWall(int r, double c) const;
 
+  // WALL EDGES: every place a wall can be has an index into one flat
+  // array of all the walls, the horizontal ones row by row and then the
+  // vertical ones.  The half way coordinate is given as a whole number
+  // of half units (2.5 is 5).
+  int horizontalEdge(int half_row, int c) const {
+    assert ((half_row & 1) && half_row >= 1 && half_row <= 2*rows+1 && c >= 1 && c <= cols);
+    return (half_row >> 1)*cols + c-1;
+  }
+  int verticalEdge(int r, int half_col) const {
+    assert ((half_col & 1) && half_col >= 1 && half_col <= 2*cols+1 && r >= 1 && r <= rows);
+    return (rows+1)*cols + (r-1)*(cols+1) + (half_col >> 1);
+  }
+  // the edge on one side of a cell
+  int cellEdge(int r, int c, int direction) const {
+    if (direction == NORTH) return horizontalEdge(2*r-1,c);
+    if (direction == SOUTH) return horizontalEdge(2*r+1,c);
+    if (direction == EAST) return verticalEdge(r,2*c+1);
+    return verticalEdge(r,2*c-1);
+  }
+
   // ACCESSORS related to the robots and their current positions
-  unsigned int numRobots() const { return robots.size(); }
+  unsigned int numRobots() const { return num_robots; }
   // lookup the assigned "id" for a robot by name 
   int whichRobot(char a) const;
   // given a robot's id, lookup the name
   char getRobot(int i) const { return robots[i]; }
   // get the robots current position
-  std::vector<Position> getRobotPositions() const { return robot_positions; }
+  std::vector<Position> getRobotPositions() const {
+    return std::vector<Position>(robot_positions,robot_positions+num_robots);
+  }
 
   // ACCESSORS related to the overal puzzle goal target location
   // the position
@@ -60,8 +226,7 @@ public:
 
 
   // MODIFIERS related to board geometry
-  void addHorizontalWall(double r, int c);
-  void addVerticalWall(int r, double c);
+  void addWall(int edge);
 
   // MODIFIERS related robot position
   // initial placement of a new robot
@@ -77,23 +242,49 @@ public:
   char getspot(const Position &p) const;
   void setspot(const Position &p, char a);
   
-  //MY SHTUFF
-  std::vector<int> t; 		//This is a vector of ints I can push back into my visualize vector of vector of ints...
-  std::vector<std::vector<int> > viz; //...which is called viz
-  std::vector<std::vector<std::string> > paths;//This is the vector of vectors of string moves
-  std::vector<Position> single; //A temporary position vector
-  Position tempos; //A temporary position
-  int mm; //max_moves in reincarnation form
-  void moveRobot(int i, const std::string &direction, int m, std::vector<Position> pos, int c, std::vector<std::string> path); //moves a robot
-  void trackMoves(int i, std::vector<Position> pos, int c, std::vector<std::string> path); //checks paths and sets vectors
-  void cycleMoves(std::vector<Position> pos, int c, std::vector<std::string> path); //cycles robots through moves
-  
-  
-  
+  // MOVING ROBOTS
+  // precompute where a robot stops sliding from each cell, ignoring the
+  // other robots (must be called after all the walls are added)
+  void computeSlideStops();
+  // where a robot sliding from a cell (row major, from 0) stops because
+  // of a wall, as a cell
+  int slideStop(int cell, int direction) const { return slideStops()[cell*4+direction]; }
+  // the solver uses bitboards for the walls and robots on boards of up
+  // to 16x16 cells (and the slide stop table on bigger boards)
+  bool hasBitboards() const { return rows <= 16 && cols <= 16; }
+  void fillOccupancy(const std::vector<Position> &pos, Occupancy &occ) const;
+  Position slideBits(const Occupancy &occ, const Position &p, int direction) const;
+  // slide robot i in a direction until it hits a wall or another robot
+  // (returns false if the robot cannot move at all)
+  bool moveRobot(std::vector<Position> &pos, int i, int direction) const;
+  // a hash of the board size, the goal position and the slide stops
+  // (all the search sees of the walls), for telling layouts apart
+  uint64_t geometryHash() const;
+  // a hash of the board size and the walls, and whether another board
+  // has the same size and walls
+  uint64_t wallHash() const;
+  bool sameWalls(const Board &other) const;
+  // take the slide stops (and wall bitboards) computed for another board
+  // with the same walls, instead of computing them again
+  void copySlideStops(const Board &other);
+  // the bytes a copy of the board takes
+  size_t memory() const { return sizeof(Board) + storage.size(); }
+
+  // robots are named by capital letters
+  static const int MAX_ROBOTS = 26;
+  // the most cells a board may have (like 1024x1024)
+  static const int MAX_CELLS = 1 << 20;
+
 private:
 
   // private helper functions
-
+  // the arrays in the storage block (see below)
+  char* cells() { return storage.get(); }
+  const char* cells() const { return storage.get(); }
+  unsigned char* walls() { return (unsigned char*)storage.get() + walls_offset; }
+  const unsigned char* walls() const { return (const unsigned char*)storage.get() + walls_offset; }
+  int* slideStops() { return (int*)(storage.get() + stops_offset); }
+  const int* slideStops() const { return (const int*)(storage.get() + stops_offset); }
 
 
   // REPRESENTATION
@@ -101,16 +292,47 @@ private:
   // the board geometry
   int rows;
   int cols;
-  std::vector<std::vector<char> > board;
-  std::vector<std::vector<bool> > vertical_walls;
-  std::vector<std::vector<bool> > horizontal_walls;
+  // the arrays that grow with the board are kept in one cache line
+  // aligned block, each starting on a cache line of its own, so that
+  // copying a board is a single allocation and memcpy:
+  // - the contents of each cell, row by row, stride bytes per row
+  // - whether there is a wall on each edge (see horizontalEdge and
+  //   verticalEdge), num_edges bytes from walls_offset
+  // - the cell (row major, from 0) where a robot sliding from each cell
+  //   stops because of a wall, indexed by cell*4 + direction, from
+  //   stops_offset (only filled in by computeSlideStops)
+  AlignedBlock storage;
+  int stride;
+  int num_edges;
+  size_t walls_offset;
+  size_t stops_offset;
+  bool has_slide_stops;
+  // the walls as bitboards (on boards of up to 16x16 cells): bit i of
+  // north_walls[c-1] is set if there is a wall on the north side of
+  // cell (i+1,c), and so on for the other sides
+  unsigned short north_walls[16];
+  unsigned short south_walls[16];
+  unsigned short east_walls[16];
+  unsigned short west_walls[16];
 
   // information about the names and current positions of the robots
-  std::vector<char> robots;
-  std::vector<Position> robot_positions;
+  int num_robots;
+  char robots[MAX_ROBOTS];
+  Position robot_positions[MAX_ROBOTS];
 
   // the goal position and the id of the robot that must reach it
   Position goal;
   // the goal robot is -1 if the puzzle is solved if any robot reaches the goal
   int goal_robot;
 };
+
+
+// a solution written compactly, as the robot name and the first letter
+// of the direction for each move (like "An,Ae,Bs")
+std::string pathText(const Board &board, const MovePath &path);
+
+// write a puzzle in the same format (see parser.h), so reading it gives
+// back the same board (the walls on the outer edges are left out)
+void writePuzzle(std::ostream &ostr, const Board &board);
+
+#endif
@@ -0,0 +1,238 @@
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "board.h"
+#include "state.h"
+
+
+// ==================================================================
+// ==================================================================
+// The file starts with a 32 byte header:
+//
+//   8 bytes   the magic string "RRCACHE2"
+//   8 bytes   the layout hash
+//   4 bytes   the number of words in a key
+//   4 bytes   the number of buckets
+//   4 bytes   the run counter, used to stamp the entries
+//   4 bytes   the write counter, odd while a flush is writing entries
+//
+// followed by the buckets.  Each entry is the key, then a 4 byte stamp,
+// then 2 bytes holding the distance plus one (0 marks an empty entry)
+// and 2 unused bytes.
+//
+// Lookups take no lock.  A flush holds the file locked for writing
+// (so only one process writes at a time) and makes the write counter
+// odd while it writes, and a lookup that sees the counter odd, or
+// changed by the time it has read the entry, counts as a miss.  The
+// file never shrinks while it is in use, so a mapping of it always
+// stays valid.
+
+static const char MAGIC[8] = { 'R','R','C','A','C','H','E','2' };
+
+// the fields of the header that change while the file is in use
+static inline uint32_t* runCounter(char *data) { return (uint32_t*)(data+24); }
+static inline uint32_t* writeCounter(char *data) { return (uint32_t*)(data+28); }
+
+// The hash of everything about a puzzle except where the robots are
+static uint64_t layoutHash(const Board &board) {
+  uint64_t layout[3] = { board.geometryHash(), board.numRobots(),
+                         (uint64_t)(board.getGoalRobot() + 1) };
+  return hashState(layout,3);
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the DistanceCache class
+
+DistanceCache::DistanceCache() : fd(-1), data(NULL), length(0), num_words(0),
+                                 num_buckets(0), entry_bytes(0) {}
+
+DistanceCache::~DistanceCache() {
+  close();
+}
+
+// Check the header of the open file against the layout, and read the
+// number of buckets from it
+bool DistanceCache::validHeader(uint64_t layout) {
+  char header[HEADER_BYTES];
+  struct stat info;
+  if (fstat(fd,&info) != 0 || info.st_size < (off_t)HEADER_BYTES ||
+      pread(fd,header,HEADER_BYTES,0) != (ssize_t)HEADER_BYTES) {
+    return false;
+  }
+  uint32_t file_words;
+  memcpy(&file_words, header+16, 4);
+  memcpy(&num_buckets, header+20, 4);
+  return (memcmp(header,MAGIC,8) == 0 && memcmp(header+8,&layout,8) == 0 &&
+          (int)file_words == num_words && num_buckets > 0 &&
+          info.st_size == (off_t)(HEADER_BYTES + (size_t)num_buckets*BUCKET_SIZE*entry_bytes));
+}
+
+bool DistanceCache::open(const std::string &dir, const Board &board, int words, long long max_bytes) {
+  close();
+  uint64_t layout = layoutHash(board);
+  num_words = words;
+  entry_bytes = words*sizeof(uint64_t) + 8;
+
+  // a file that is there but isn't a cache of this layout (from an older
+  // version, or left half made) may still be mapped by someone, so it is
+  // never changed; the next name is tried instead
+  for (int attempt = 0; attempt < 4 && fd == -1; attempt++) {
+    char name[40];
+    if (attempt == 0) {
+      snprintf(name, sizeof(name), "/%016llx.cache", (unsigned long long)layout);
+    } else {
+      snprintf(name, sizeof(name), "/%016llx-%d.cache", (unsigned long long)layout, attempt);
+    }
+    std::string path = dir + name;
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1) return false;
+
+    // reading the header only needs a shared lock
+    flock(fd, LOCK_SH);
+    bool valid = validHeader(layout);
+    flock(fd, LOCK_UN);
+    if (valid) break;
+
+    // a new (empty) file is set up while no one else can use it, unless
+    // someone else got to it first
+    flock(fd, LOCK_EX);
+    struct stat info;
+    if (!validHeader(layout) &&
+        fstat(fd,&info) == 0 && info.st_size == 0) {
+      long long buckets = (max_bytes - (long long)HEADER_BYTES) / (long long)(BUCKET_SIZE*entry_bytes);
+      if (buckets > (1LL << 28)) buckets = 1LL << 28;
+      num_buckets = (buckets < 1) ? 1 : buckets;
+      char header[HEADER_BYTES];
+      memset(header,0,HEADER_BYTES);
+      memcpy(header,MAGIC,8);
+      memcpy(header+8,&layout,8);
+      uint32_t file_words = words;
+      memcpy(header+16,&file_words,4);
+      memcpy(header+20,&num_buckets,4);
+      if (ftruncate(fd,HEADER_BYTES + (size_t)num_buckets*BUCKET_SIZE*entry_bytes) != 0 ||
+          pwrite(fd,header,HEADER_BYTES,0) != (ssize_t)HEADER_BYTES) {
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        fd = -1;
+        return false;
+      }
+    }
+    valid = validHeader(layout);
+    flock(fd, LOCK_UN);
+    if (!valid) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  if (fd == -1) return false;
+
+  length = HEADER_BYTES + (size_t)num_buckets*BUCKET_SIZE*entry_bytes;
+  void *mapped = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+  data = (char*)mapped;
+  return true;
+}
+
+void DistanceCache::close() {
+  if (!isOpen()) return;
+  flush();
+  munmap(data,length);
+  ::close(fd);
+  data = NULL;
+  fd = -1;
+}
+
+unsigned int DistanceCache::bucketOf(const uint64_t *key) const {
+  return hashState(key,num_words) % num_buckets;
+}
+
+// A hit also stamps the entry with the current run, so the entries
+// that are looked up stay in the cache.  The stamp is only a hint for
+// eviction, so it is written without any lock.
+int DistanceCache::find(const uint64_t *key) const {
+  assert (isOpen());
+  uint32_t writes = __atomic_load_n(writeCounter(data), __ATOMIC_ACQUIRE);
+  if (writes % 2 == 1) return -1;
+  unsigned int bucket = bucketOf(key);
+  size_t key_bytes = num_words*sizeof(uint64_t);
+  int answer = -1;
+  char *e = NULL;
+  for (int i = 0; i < BUCKET_SIZE && answer == -1; i++) {
+    e = entry(bucket,i);
+    uint16_t distance;
+    memcpy(&distance, e+key_bytes+4, 2);
+    if (distance != 0 && memcmp(e,key,key_bytes) == 0) answer = distance-1;
+  }
+  // the entry may have changed while it was read
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (answer == -1 || __atomic_load_n(writeCounter(data), __ATOMIC_RELAXED) != writes) return -1;
+  uint32_t run = __atomic_load_n(runCounter(data), __ATOMIC_RELAXED);
+  uint32_t *stamp = (uint32_t*)(e+key_bytes);
+  if (__atomic_load_n(stamp, __ATOMIC_RELAXED) != run) __atomic_store_n(stamp, run, __ATOMIC_RELAXED);
+  return answer;
+}
+
+void DistanceCache::store(const uint64_t *key, int distance) {
+  assert (distance >= 0 && distance < 65535);
+  pending.insert(pending.end(), key, key+num_words);
+  pending.push_back(distance);
+}
+
+void DistanceCache::flush() {
+  if (!isOpen() || pending.empty()) return;
+  flock(fd, LOCK_EX);
+  uint32_t *writes = writeCounter(data);
+  __atomic_store_n(writes, *writes + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  uint32_t stamp = *runCounter(data) + 1;
+  __atomic_store_n(runCounter(data), stamp, __ATOMIC_RELAXED);
+  for (size_t k = 0; k < pending.size(); k += num_words+1) {
+    write(&pending[k], pending[k+num_words], stamp);
+  }
+  pending.clear();
+  __atomic_store_n(writes, *writes + 1, __ATOMIC_RELEASE);
+  flock(fd, LOCK_UN);
+}
+
+// Put an entry in its bucket: over the same key if it is there, else in
+// an empty entry, else over the entry with the oldest stamp
+void DistanceCache::write(const uint64_t *key, int distance, uint32_t stamp) {
+  unsigned int bucket = bucketOf(key);
+  size_t key_bytes = num_words*sizeof(uint64_t);
+  char *slot = NULL;
+  uint32_t oldest = 0;
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    char *e = entry(bucket,i);
+    uint32_t e_stamp;
+    uint16_t e_distance;
+    memcpy(&e_stamp, e+key_bytes, 4);
+    memcpy(&e_distance, e+key_bytes+4, 2);
+    if (e_distance == 0) {
+      // an empty entry beats any used one (but keep looking for the key)
+      if (slot == NULL || oldest != 0) slot = e;
+      oldest = 0;
+    } else if (memcmp(e,key,key_bytes) == 0) {
+      slot = e;
+      break;
+    } else if (slot == NULL || e_stamp < oldest) {
+      slot = e;
+      oldest = e_stamp;
+    }
+  }
+  uint16_t value = distance+1;
+  memcpy(slot, key, key_bytes);
+  memcpy(slot+key_bytes, &stamp, 4);
+  memcpy(slot+key_bytes+4, &value, 2);
+}
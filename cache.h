@@ -0,0 +1,82 @@
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class Board;
+
+
+// ==================================================================
+// ==================================================================
+// An on-disk cache of the exact number of moves from configurations to
+// the goal, kept from one run to the next.  There is one file per
+// layout (board size, walls, goal, goal robot and number of robots),
+// named by a hash of the layout, in a cache directory.  The file is a
+// fixed size hash table that is memory mapped, so looking up a
+// configuration costs about as much as a StateTable lookup.
+//
+// The table is split into buckets of a few entries.  Each entry is
+// stamped with the run that last wrote or found it, and when a bucket
+// is full the least recently used entry (the one with the oldest stamp)
+// is evicted, so the file never grows past the size it was created
+// with.
+//
+// Any number of solvers, in this process or others, can look entries
+// up at once without locking (and find is safe to call from several
+// threads); a lookup that overlaps a write is just a miss.  New entries
+// are only collected in memory until flush, which briefly locks the
+// file for writing.  A file in the way that isn't a cache of the layout
+// is left alone, and the cache goes in a file of another name.
+
+class DistanceCache {
+public:
+  DistanceCache();
+  ~DistanceCache();
+
+  // open (or create, with at most max_bytes) the cache file for the
+  // layout of board, for configurations packed into words 64 bit words.
+  // Returns false (leaving the cache closed) if it can't be used.
+  bool open(const std::string &dir, const Board &board, int words, long long max_bytes);
+  // write the collected entries and close the file
+  void close();
+  bool isOpen() const { return data != NULL; }
+
+  // the number of moves from key to the goal, or -1 if it isn't cached
+  // (a hit marks the entry as used in this run)
+  int find(const uint64_t *key) const;
+  // remember the number of moves from key to the goal, for flush
+  // (storing an entry that is already there makes it the newest)
+  void store(const uint64_t *key, int distance);
+  // write everything remembered since the last flush into the file
+  void flush();
+
+private:
+  // the file and mapping can't be shared between two caches
+  DistanceCache(const DistanceCache&);
+  DistanceCache& operator=(const DistanceCache&);
+
+  bool validHeader(uint64_t layout);
+  unsigned int bucketOf(const uint64_t *key) const;
+  char* entry(unsigned int bucket, int i) const {
+    return data + HEADER_BYTES + ((size_t)bucket*BUCKET_SIZE + i)*entry_bytes;
+  }
+  void write(const uint64_t *key, int distance, uint32_t stamp);
+
+  static const int BUCKET_SIZE = 8;
+  static const size_t HEADER_BYTES = 32;
+
+  // the open file and its mapping
+  int fd;
+  char *data;
+  size_t length;
+  // the layout of the table
+  int num_words;
+  unsigned int num_buckets;
+  size_t entry_bytes;
+  // the entries to write at the next flush (key words then distance)
+  std::vector<uint64_t> pending;
+};
+
+#endif
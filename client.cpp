@@ -0,0 +1,78 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// ================================================================
+// ================================================================
+// A small client for the solver server (started with -serve): sends
+// each puzzle file to the server and prints the file name and the line
+// the server answers with, like batch mode does.
+
+// send one request and return the answer (exits if the server can't be
+// reached)
+std::string request(const std::string &socket_path, const std::string &puzzle) {
+  struct sockaddr_un addr;
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "ERROR: the socket path " << socket_path << " is too long" << std::endl;
+    exit(1);
+  }
+  strcpy(addr.sun_path,socket_path.c_str());
+  int fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (fd < 0 || connect(fd,(struct sockaddr*)&addr,sizeof(addr)) != 0) {
+    std::cerr << "ERROR: could not connect to " << socket_path << ": " << strerror(errno) << std::endl;
+    exit(1);
+  }
+
+  // the request ends when this side of the connection is closed
+  size_t done = 0;
+  while (done < puzzle.size()) {
+    ssize_t n = write(fd, puzzle.data() + done, puzzle.size() - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    done += n;
+  }
+  shutdown(fd,SHUT_WR);
+
+  std::string answer;
+  char buffer[4096];
+  while (true) {
+    ssize_t n = read(fd,buffer,sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    answer.append(buffer,n);
+  }
+  close(fd);
+  // drop the newline at the end
+  if (!answer.empty() && answer[answer.size()-1] == '\n') answer.erase(answer.size()-1);
+  return answer;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <socket_path> <puzzle_file> ..." << std::endl;
+    exit(1);
+  }
+  // a busy server answers and hangs up before reading the request
+  signal(SIGPIPE,SIG_IGN);
+  for (int i = 2; i < argc; i++) {
+    std::ifstream istr(argv[i]);
+    if (!istr) {
+      std::cerr << "ERROR: could not open " << argv[i] << " for reading" << std::endl;
+      exit(1);
+    }
+    std::ostringstream puzzle;
+    puzzle << istr.rdbuf();
+    std::cout << argv[i] << " " << request(argv[1],puzzle.str()) << std::endl;
+  }
+  return 0;
+}
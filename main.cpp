@@ -2,9 +2,22 @@
 #include <string>
 #include <cassert>
 #include <cstdlib>
+#include <climits>
+#include <cerrno>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <dirent.h>
 
 #include "board.h"
+#include "parser.h"
+#include "solver.h"
+#include "pool.h"
+#include "server.h"
 
 // ================================================================
 // ================================================================
@@ -13,64 +26,237 @@ bool usage(const std::string &executable_name) {
   std::cerr << "Usage: " << executable_name << " <puzzle_file>" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#>" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -all_solutions" << std::endl;
+  std::cerr << "       " << executable_name << " <puzzle_file> -count_solutions" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -visualize_accessibility" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -all_solutions" << std::endl;
   std::cerr << "       " << executable_name << " <puzzle_file> -max_moves <#> -visualize_accessibility" << std::endl;
+  std::cerr << "       (-visualize_accessibility can be followed by -per_robot)" << std::endl;
+  std::cerr << "       " << executable_name << " -batch <list_file|directory|container_file> [-max_moves <#>]" << std::endl;
+  std::cerr << "       (in batch mode, -threads is the number of puzzles solved at once)" << std::endl;
+  std::cerr << "       " << executable_name << " -serve <socket_path> [-max_moves <#>] [-queue <#>] [-geometries <#>]" << std::endl;
+  std::cerr << "       (as a server, -threads is the number of requests answered at once)" << std::endl;
+  std::cerr << "       (outside batch mode, -stats prints the search counters to stderr)" << std::endl;
+  std::cerr << "       (any of the above can also be followed by -threads <#>, -ida, -bidirectional," << std::endl;
+  std::cerr << "        -mem_limit <bytes>, -cache <directory>, -cache_size <bytes>," << std::endl;
+  std::cerr << "        where the bytes can end in K, M or G, and after -ida by -pdb <file>)" << std::endl;
   exit(0);
 }
 
 
 // ================================================================
 // ================================================================
-// load a Ricochet Robots puzzle from the input file
-Board load(const std::string &executable, const std::string &filename) {
+// read a number of bytes like "4G" or "512M" (-1 if it isn't one)
+long long parseBytes(const std::string &text) {
+  char *end;
+  errno = 0;
+  long long value = strtoll(text.c_str(),&end,10);
+  if (end == text.c_str() || value <= 0 || errno == ERANGE) return -1;
+  std::string unit(end);
+  int shift;
+  if (unit == "K" || unit == "k") shift = 10;
+  else if (unit == "M" || unit == "m") shift = 20;
+  else if (unit == "G" || unit == "g") shift = 30;
+  else if (unit == "") shift = 0;
+  else return -1;
+  // too many bytes to count
+  if (value > (LLONG_MAX >> shift)) return -1;
+  return value << shift;
+}
+
+
+// ================================================================
+// ================================================================
+// output the fewest number of moves needed to reach each cell (or '.'
+// if it cannot be reached, and '?' if the search ran out of memory
+// before finding out)
+void printAccessibility(const Board &board, const Grid<int> &viz) {
+  for (int i = 1; i <= board.getRows(); i++) {
+    for (int j = 1; j <= board.getCols(); j++) {
+      if (viz[i][j] == SolverResult::UNKNOWN) {
+        std::cout << "? ";
+      } else if (viz[i][j] != -1) {
+        std::cout << viz[i][j] << " ";
+      } else {
+        std::cout << ". ";
+      }
+    }
+    std::cout << std::endl;
+  }
+}
+
+
+// ================================================================
+// ================================================================
+// print the counters of a search to stderr (so the regular output is
+// unchanged), one "stats <name> <value>" line each, then one
+// "stats depth <depth> <seconds>" line per layer or iteration
+void printStats(const SolverResult &result, double seconds) {
+  const SolverStats &stats = result.stats;
+  std::ostream &ostr = std::cerr;
+  ostr << "stats seconds " << std::fixed << std::setprecision(6) << seconds << std::endl;
+  ostr << "stats cell_bits " << stats.cell_bits << std::endl;
+  ostr << "stats key_words " << stats.key_words << std::endl;
+  ostr << "stats expanded " << result.expanded << std::endl;
+  ostr << "stats generated " << stats.generated << std::endl;
+  ostr << "stats duplicates " << stats.duplicates << std::endl;
+  ostr << "stats slides " << stats.slides << std::endl;
+  ostr << "stats lookups " << stats.probes.lookups << std::endl;
+  ostr << "stats probes " << stats.probes.probes << std::endl;
+  ostr << "stats table_size " << stats.table_size << std::endl;
+  ostr << "stats table_slots " << stats.table_slots << std::endl;
+  ostr << "stats load_factor "
+       << (stats.table_slots ? double(stats.table_size) / stats.table_slots : 0.0) << std::endl;
+  ostr << "stats peak_frontier " << stats.peak_frontier << std::endl;
+  for (unsigned int d = 0; d < stats.depth_seconds.size(); d++) {
+    ostr << "stats depth " << d+1 << " " << stats.depth_seconds[d] << std::endl;
+  }
+}
+
+
+// ================================================================
+// ================================================================
+// the text printed for a move, like "robot A moves north"
+std::string moveText(const Board &board, Move m) {
+  return std::string("robot ") + board.getRobot(moveRobotId(m)) + " moves " + directionName(moveDirection(m));
+}
+
 
-  // open the file for reading
-  std::ifstream istr (filename.c_str());
+// ================================================================
+// ================================================================
+// the puzzle files to solve in batch mode: every file in a directory
+// (in alphabetical order), or the file names listed one per line in a
+// list file
+std::vector<std::string> batchFiles(const std::string &executable, const std::string &list) {
+  std::vector<std::string> files;
+  DIR *dir = opendir(list.c_str());
+  if (dir != NULL) {
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      std::string name = entry->d_name;
+      if (name[0] == '.') continue;
+      files.push_back(list + "/" + name);
+    }
+    closedir(dir);
+    std::sort(files.begin(),files.end());
+    return files;
+  }
+  std::ifstream istr(list.c_str());
   if (!istr) {
-    std::cerr << "ERROR: could not open " << filename << " for reading" << std::endl;
+    std::cerr << "ERROR: could not open " << list << " for reading" << std::endl;
     usage(executable);
   }
+  std::string line;
+  while (std::getline(istr,line)) {
+    if (line.empty()) continue;
+    files.push_back(line);
+  }
+  return files;
+}
 
-  // read in the board dimensions and create an empty board
-  // (all outer edges are automatically set to be walls
-  int rows,cols;
-  istr >> rows >> cols;
-  Board answer(rows,cols);
-
-  // read in the other characteristics of the puzzle board
-  std::string token;
-  while (istr >> token) {
-    if (token == "robot") {
-      char a;
-      int r,c;
-      istr >> a >> r >> c;
-      answer.placeRobot(Position(r,c),a);
-    } else if (token == "vertical_wall") {
-      int i;
-      double j;
-      istr >> i >> j;
-      answer.addVerticalWall(i,j);
-    } else if (token == "horizontal_wall") {
-      double i;
-      int j;
-      istr >> i >> j;
-      answer.addHorizontalWall(i,j);
-    } else if (token == "goal") {
-      std::string which_robot;
-      int r,c;
-      istr >> which_robot >> r >> c;
-      answer.setGoal(which_robot,Position(r,c));
-    } else {
-      std::cerr << "ERROR: unknown token in the input file " << token << std::endl;
-      exit(0);
-    }
+// Why the pattern database given with -pdb went unused for a puzzle
+// ("" if it was used, or none was given)
+std::string pdbProblem(const Board &board, const SolverOptions &options,
+                       const SolverResult &result) {
+  if (options.pdb_file.empty() || result.pdb_used) return "";
+  if (board.getGoalRobot() == -1) {
+    return options.pdb_file + " is not used: the puzzle has no goal robot";
   }
+  return options.pdb_file + " is not used: it can't be read or is not a pattern database for this layout";
+}
 
-  // return the initialized board
-  return answer;
+// Solve one puzzle of a batch, from its text, and format its line of
+// output:
+//   <name> <# of moves> <solution> <configurations expanded> <seconds>
+// where the solution is written compactly as the robot name and the
+// first letter of the direction for each move (like "An,Ae,Bs"), and
+// an unsolved puzzle has "-" for the number of moves and the solution.
+// An invalid puzzle gets "ERROR: <line>:<column>: <description>"
+// instead, and the batch goes on.
+std::string solveOne(const std::string &name, const PuzzleSpan &puzzle,
+                     const SolverOptions &options, Solver &solver) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::ostringstream line;
+  line << name << " ";
+  Board board(1,1);
+  PuzzleParser parser(puzzle);
+  if (!parser.parse(board)) {
+    line << "ERROR: " << parser.error();
+    return line.str();
+  }
+  board.computeSlideStops();
+  SolverResult result = solver.solve(board,options);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::string problem = pdbProblem(board,options,result);
+  if (!problem.empty()) std::cerr << "WARNING: " << name << ": " << problem << std::endl;
+
+  if (result.paths.empty()) {
+    line << "- -";
+  } else {
+    line << result.moves << " " << pathText(board,result.paths[0]);
+  }
+  line << " " << result.expanded << " " << std::fixed << std::setprecision(6) << seconds;
+  return line.str();
+}
+
+// the same for a puzzle file, which is read by the worker solving it
+std::string solveFile(const std::string &file, const SolverOptions &options, Solver &solver) {
+  MappedFile text;
+  if (!text.open(file)) return file + " ERROR: could not open " + file + " for reading";
+  std::vector<PuzzleSpan> spans = splitPuzzles(text.begin(),text.end());
+  if (spans.size() != 1) {
+    std::ostringstream line;
+    line << file << " ERROR: 1:1: there are " << spans.size() << " puzzles instead of one";
+    return line.str();
+  }
+  return solveOne(file,spans[0],options,solver);
 }
 
+// Solve many puzzles in one process, printing one line per puzzle.
+// The puzzles are either the puzzle files of a directory or list file,
+// or all the puzzles of a container file (see parser.h), each named by
+// its name in the container.  They are spread over a pool of worker
+// threads (each puzzle is solved by a single thread), and each worker
+// keeps its own Solver for all the puzzles it solves.  The lines are
+// printed in the order of the input as soon as all the puzzles before
+// them are done.
+void batch(const std::string &executable, const std::string &list,
+           const SolverOptions &options, int workers) {
+  // a container is mapped once and split, and the workers parse their
+  // own puzzles straight from it
+  MappedFile container;
+  std::vector<PuzzleSpan> spans;
+  std::vector<std::string> files;
+  if (container.open(list) && isPuzzleContainer(container.begin(),container.end())) {
+    spans = splitPuzzles(container.begin(),container.end());
+  } else {
+    container.close();
+    files = batchFiles(executable,list);
+  }
+  unsigned int count = spans.empty() ? files.size() : spans.size();
+
+  WorkStealingPool pool(workers);
+  std::vector<Solver> solvers(workers);
+
+  std::vector<std::string> lines(count);
+  std::vector<bool> done(count,false);
+  unsigned int next_to_print = 0;
+  std::mutex print_lock;
+
+  pool.run(count, [&](int worker, int i) {
+    std::string line = spans.empty() ? solveFile(files[i],options,solvers[worker])
+                                     : solveOne(spans[i].name,spans[i],options,solvers[worker]);
+    std::lock_guard<std::mutex> guard(print_lock);
+    lines[i] = line;
+    done[i] = true;
+    while (next_to_print < count && done[next_to_print]) {
+      std::cout << lines[next_to_print] << std::endl;
+      lines[next_to_print].clear();
+      next_to_print++;
+    }
+  });
+}
+
+
 // ================================================================
 // ================================================================
 
@@ -81,170 +267,238 @@ int main(int argc, char* argv[]) {
     usage(argv[0]);
   }
 
-  // By default, the maximum number of moves is unlimited
-  int max_moves = -1;
+  // By default, the maximum number of moves is unlimited, one solution
+  // using the minimum number of moves is output, the accessibility is
+  // not visualized and the breadth first search is used
+  SolverOptions options;
+
+  // By default, search with a single thread (in batch mode, solve one
+  // puzzle at a time on every core)
+  int threads = 0;
 
-  // By default, output one solution using the minimum number of moves
-  bool all_solutions = false;
+  // Print the search counters after solving
+  bool stats = false;
 
-  // By default, do not visualize the accessibility
-  bool visualize_accessibility = false;
+  // In batch mode the puzzle file is replaced by a list of puzzles,
+  // and in server mode by the socket to listen on
+  std::string batch_list;
+  std::string socket_path;
+  int first_arg = 2;
+  if (argv[1] == std::string("-batch")) {
+    if (argc < 3) usage(argv[0]);
+    batch_list = argv[2];
+    first_arg = 3;
+  } else if (argv[1] == std::string("-serve")) {
+    if (argc < 3) usage(argv[0]);
+    socket_path = argv[2];
+    first_arg = 3;
+  }
+  // the server's bound on the waiting requests, and on the geometries
+  // it keeps the slide stops of
+  int queue_length = 64;
+  int geometries = 256;
 
   // Read in the other command line arguments
-  for (int arg = 2; arg < argc; arg++) {
+  for (int arg = first_arg; arg < argc; arg++) {
     if (argv[arg] == std::string("-all_solutions")) {
       // find all solutions to the puzzle that use the fewest number of moves
-      all_solutions = true;
+      options.all_solutions = true;
+    } else if (argv[arg] == std::string("-count_solutions")) {
+      // only count the solutions that use the fewest number of moves
+      options.count_solutions = true;
     } else if (argv[arg] == std::string("-max_moves")) {
       // the next command line arg is an integer, a cap on the  # of moves
       arg++;
       assert (arg < argc);
-      max_moves = atoi(argv[arg]);
-      assert (max_moves > 0);
+      options.max_moves = atoi(argv[arg]);
+      assert (options.max_moves > 0);
     } else if (argv[arg] == std::string("-visualize_accessibility")) {
       // As a first step towards solving the whole problem, with this
       // option, let's visualize where the robots can move and how many
       // steps it takes to get there
-      visualize_accessibility = true;
+      options.accessibility = true;
+    } else if (argv[arg] == std::string("-per_robot")) {
+      // also show the accessibility of each robot on its own
+      options.per_robot = true;
+    } else if (argv[arg] == std::string("-threads")) {
+      // the next command line arg is the number of threads used to
+      // expand each layer of the search
+      arg++;
+      assert (arg < argc);
+      threads = atoi(argv[arg]);
+      assert (threads > 0);
+    } else if (argv[arg] == std::string("-ida")) {
+      // use iterative deepening A*, which needs much less memory than
+      // the breadth first search on puzzles with long solutions
+      options.ida = true;
+    } else if (argv[arg] == std::string("-bidirectional")) {
+      // when a particular robot must reach the goal, also search
+      // backwards from the goal and meet in the middle
+      options.bidirectional = true;
+    } else if (argv[arg] == std::string("-mem_limit")) {
+      // the next command line arg is the memory the search may use
+      // before the breadth first search gives way to iterative deepening
+      arg++;
+      if (arg >= argc) usage(argv[0]);
+      options.mem_limit = parseBytes(argv[arg]);
+      if (options.mem_limit == -1) usage(argv[0]);
+    } else if (argv[arg] == std::string("-cache")) {
+      // the next command line arg is a directory where the moves needed
+      // from configurations on the way to solutions are kept between runs
+      arg++;
+      if (arg >= argc) usage(argv[0]);
+      options.cache_dir = argv[arg];
+      DIR *dir = opendir(argv[arg]);
+      if (dir == NULL) {
+        std::cerr << "ERROR: cannot open cache directory " << argv[arg] << std::endl;
+        usage(argv[0]);
+      }
+      closedir(dir);
+    } else if (argv[arg] == std::string("-cache_size")) {
+      // the next command line arg is the size of a new cache file
+      arg++;
+      if (arg >= argc) usage(argv[0]);
+      options.cache_size = parseBytes(argv[arg]);
+      if (options.cache_size == -1) usage(argv[0]);
+    } else if (argv[arg] == std::string("-pdb")) {
+      // the next command line arg is a pattern database made by pdbgen
+      arg++;
+      if (arg >= argc) usage(argv[0]);
+      options.pdb_file = argv[arg];
+    } else if (argv[arg] == std::string("-queue")) {
+      // the next command line arg is how many requests may wait
+      arg++;
+      if (arg >= argc || socket_path.empty()) usage(argv[0]);
+      queue_length = atoi(argv[arg]);
+      if (queue_length < 1) usage(argv[0]);
+    } else if (argv[arg] == std::string("-geometries")) {
+      // the next command line arg is how many geometries are cached
+      arg++;
+      if (arg >= argc || socket_path.empty()) usage(argv[0]);
+      geometries = atoi(argv[arg]);
+      if (geometries < 1) usage(argv[0]);
+    } else if (argv[arg] == std::string("-stats")) {
+      // print the counters of the search (to stderr)
+      stats = true;
     } else {
       std::cout << "unknown command line argument" << argv[arg] << std::endl;
       usage(argv[0]);
     }
   }
 
+  // the per robot maps are only part of the accessibility output
+  if (options.per_robot && !options.accessibility) usage(argv[0]);
+  // only iterative deepening uses a pattern database
+  if (!options.pdb_file.empty() && (!options.ida || options.accessibility)) usage(argv[0]);
+
+  if (!socket_path.empty()) {
+    // like batch mode, only the first optimal solution is answered
+    if (options.all_solutions || options.count_solutions || options.accessibility || stats) {
+      usage(argv[0]);
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    SolverServer server(socket_path,options,threads,queue_length,geometries);
+    server.run();
+    return 1;
+  }
+
+  if (!batch_list.empty()) {
+    // only the first optimal solution of each puzzle is reported
+    if (options.all_solutions || options.count_solutions || options.accessibility || stats) {
+      usage(argv[0]);
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // the puzzles solved at once share the memory budget
+    options.mem_limit /= threads;
+    batch(argv[0],batch_list,options,threads);
+    return 0;
+  }
+  options.threads = std::max(threads,1);
+
   // Load the puzzle board from the input file
-  Board board = load(argv[0],argv[1]);
-
-  //
-  //
-  // YOUR CODE STARTS HERE //Indeed it does...
-  //
-  //
-
-	for (int i = 0; i < board.getRows()+1; i++) //First we set up the size of the visualization vector
-	{
-		for (int j = 0; j < board.getCols()+1; j++) //Don't worry we get to the recursion later... 
-		{
-			int tmp = -1;
-			board.t.push_back(tmp); //Yes my visualization vector is a public variable... but this is the second time I've written the program from scratch
-		}
-		board.viz.push_back(board.t); //And my last late day... so spare a little mercy
-	}
-	for(unsigned int i = 0; i < board.numRobots(); i++) //Then we add the robots to a vector
-	{
-		Position P = board.getRobotPositions()[i];
-		int y = P.row;
-		int x = P.col;
-		board.viz[y][x] = 0;
-	}
-	std::vector<std::string> path; //This vector keeps track of an individual robot path
-	board.mm = max_moves; //This tells the rest of my functions what the max number of moves are
-	std::vector<Position> pos = board.getRobotPositions(); //This vector of positions tells my functions where the robots are... 
-	board.single = board.getRobotPositions(); //This does the same thing but only for a single output run
-	board.trackMoves(0, pos, 0, path); //And here we send the positions and a fresh path vector off to neverland
-	max_moves = board.mm; //Once neverland finishes processing... we have to see how many moves it took
-
-if (visualize_accessibility == true) //If we are just visualizing it
-{
-	for (int i = 1; i < board.getRows()+1; i++)
-	{
-		for (int j = 1; j < board.getCols()+1; j++)  //Then we loop through and display the visualize vector
-		{
-			if(board.viz[i][j] != -1)
-			{
-				std::cout<<board.viz[i][j]<< " "; //trackMoves is how this vector got populated (see board.cpp)
-			}
-			else
-			{
-				std::cout<<"."<<" "; //Because my vector is ints not chars... we have to change the -1's to periods
-			}
-		}
-		std::cout << std::endl;
-	}
-return 0; //Then we are done
-}
-else if (all_solutions == true) //If all solutions are true
-{
-	board.print(); //We print the initial board
-	if (board.paths.size() == 0) //paths is a vector of vectors of strings... each string representing a move
-	{
-	if (max_moves == -1)
-	{
-		std::cout<<"no solutions found"<<std::endl; //If max moves wasn't specified and we get tossed out
-		return 0; 
-	}
-	std::cout<<"no solutions with " << max_moves << " or fewer moves"<<std::endl; //Otherwise we specify the number of moves that resulted in no paths
-	return 0;
-	}
-	else
-	{
-		std::cout<<board.paths.size()<<" different "<< board.paths[0].size() << " move solutions:"<<std::endl; //Otherwise... we say how many moves there are
-	}
-	std::cout<<std::endl;
-	for (int i = 0; i < board.paths.size(); i++)
-	{
-		for (int j = 0; j < board.paths[i].size(); j++)
-		{
-			std::cout<<board.paths[i][j]<<std::endl; //then we output all of the paths
-		}
-		std::cout<<"robot " << board.paths[i][board.paths[i].size()-1][6] << " reaches the goal after " << board.paths[0].size() << " moves"<< std::endl; //Looking at the last path
-		std::cout<<std::endl;															//to determine which robot reached the goal... by parsing the string of the path
-	}
-}
-else
-{
-	board.print();  //This one is the most tricky
-	std::string x; //This is a temporary string
-	if (board.paths.size() == 0)
-	{
-		if (max_moves == -1)
-		{
-			std::cout<<"no solutions found"<<std::endl; //Once again for no solutions we do the same thing
-			return 0;
-		}		
-		std::cout<<"no solutions with " << max_moves << " or fewer moves"<<std::endl; 
-		return 0;
-	}
-	for (int j = 0; j < board.paths[0].size(); j++)
-	{
-		if (j != 0)
-		{
-			board.print(); //Then we print the initial board
-		}
-		std::cout<<board.paths[0][j]<<std::endl; //So this gets kinda weird... but essentially
-		x = board.paths[0][j]; //I only returned strings of directions from my program earlier
-		std::string direction; //So I have to parse each string and figure out what it means
-		int z = board.whichRobot(x[6]);
-		if (x[14] == 'e')
-		{
-			direction = "east";
-		}
-		if (x[14] == 'w')
-		{
-			direction = "west";
-		}
-		if (x[14] == 's')
-		{
-			direction = "south";
-		}
-		if (x[14] == 'n')
-		{
-			direction = "north";
-		}
-		std::vector<std::string> tempath;
-		board.mm = -2; //-2 is a number of max moves that wont be tested normally
-		board.moveRobot(z, direction, 0, board.single, 0, tempath); //my moving function recognizes this and moves the robot without recursing over and over
-		board.setspot(board.single[z], ' '); //In my board.cpp I set the position of the robot character
-		board.single[z].col = board.tempos.col; //Using this we can continue to output the correct position
-		board.single[z].row = board.tempos.row;
-	}
-	board.print();
-	std::cout<<"robot " << x[6] << " reaches the goal after " << board.paths[0].size() << " moves"<< std::endl;
-	
-}
+  Board board = readPuzzle(argv[1]);
+  // the walls are in place, so work out where robots stop sliding
+  board.computeSlideStops();
 
+  // The board is printed before searching, so that with -all_solutions
+  // each solution can be printed as soon as it is found rather than
+  // all of them being kept until the end
+  if (!options.accessibility) board.print();
+  unsigned long long printed = 0;
+  if (options.all_solutions) {
+    options.on_solution = [&](const MovePath &path, unsigned long long total) {
+      if (printed++ == 0) {
+        std::cout << total << " different " << path.size() << " move solutions:" << std::endl;
+        std::cout << std::endl;
+      }
+      for (unsigned int j = 0; j < path.size(); j++) {
+        std::cout << moveText(board,path[j]) << std::endl;
+      }
+      std::cout << "robot " << board.getRobot(moveRobotId(path.back()))
+                << " reaches the goal after " << path.size() << " moves" << std::endl;
+      std::cout << std::endl;
+    };
+  }
 
+  // Search for the optimal solution(s)
+  Solver solver;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  SolverResult result = solver.solve(board,options);
+  std::string problem = pdbProblem(board,options,result);
+  if (!problem.empty()) std::cerr << "WARNING: " << problem << std::endl;
+  if (stats) {
+    printStats(result,std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
 
+  if (options.accessibility) {
+    if (result.out_of_memory) {
+      std::cerr << "WARNING: the search ran out of memory, so the map is incomplete"
+                << " (the cells marked ? were not labeled)" << std::endl;
+    }
+    // output the fewest number of moves needed for any robot to reach
+    // each cell, then (if requested) for each robot
+    printAccessibility(board,result.accessibility);
+    for (unsigned int i = 0; i < result.robot_accessibility.size(); i++) {
+      std::cout << std::endl << "robot " << board.getRobot(i) << ":" << std::endl;
+      printAccessibility(board,result.robot_accessibility[i]);
+    }
+    return 0;
+  }
+
+  if (result.moves == -1) {
+    if (options.max_moves != -1) {
+      std::cout << "no solutions with " << options.max_moves << " or fewer moves" << std::endl;
+    } else if (result.at_limit) {
+      // the search gave up at the deepest it can go
+      std::cout << "no solutions with " << Solver::MAX_MOVES << " or fewer moves" << std::endl;
+    } else {
+      std::cout << "no solutions found" << std::endl;
+    }
+    return 0;
+  }
+
+  if (options.all_solutions) {
+    // every solution was printed as it was found
+  } else if (options.count_solutions) {
+    std::cout << result.solutions << " different " << result.moves << " move solutions" << std::endl;
+  } else {
+    // replay the first solution, printing the board after each move
+    const MovePath &path = result.paths[0];
+    std::vector<Position> pos = board.getRobotPositions();
+    for (unsigned int j = 0; j < path.size(); j++) {
+      if (j != 0) {
+        board.print();
+      }
+      std::cout << moveText(board,path[j]) << std::endl;
+      int i = moveRobotId(path[j]);
+      board.setspot(pos[i],' ');
+      board.moveRobot(pos,i,moveDirection(path[j]));
+      board.setspot(pos[i],board.getRobot(i));
+    }
+    board.print();
+    std::cout << "robot " << board.getRobot(moveRobotId(path.back()))
+              << " reaches the goal after " << result.moves << " moves" << std::endl;
+  }
 }
 
 // ================================================================
@@ -0,0 +1,343 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "parser.h"
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the MappedFile class
+
+bool MappedFile::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(),O_RDONLY);
+  if (fd < 0) return false;
+  struct stat info;
+  if (fstat(fd,&info) != 0 || S_ISDIR(info.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  if (S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *address = mmap(NULL,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if (address != MAP_FAILED) {
+      // the file is read from start to end once
+      madvise(address,info.st_size,MADV_SEQUENTIAL);
+      ::close(fd);
+      data = (const char*)address;
+      length = info.st_size;
+      mapped = true;
+      return true;
+    }
+  }
+
+  // read it in instead
+  char buffer[65536];
+  while (true) {
+    ssize_t n = read(fd,buffer,sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) {
+      ::close(fd);
+      contents.clear();
+      return false;
+    }
+    if (n == 0) break;
+    contents.append(buffer,n);
+  }
+  ::close(fd);
+  data = contents.data();
+  length = contents.size();
+  return true;
+}
+
+void MappedFile::close() {
+  if (mapped) munmap((void*)data,length);
+  contents.clear();
+  data = NULL;
+  length = 0;
+  mapped = false;
+}
+
+
+// ==================================================================
+// ==================================================================
+// Splitting a container into its puzzles
+
+static inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// the end of the line that p is on (the newline, or end)
+static inline const char* lineEnd(const char *p, const char *end) {
+  const char *newline = (const char*)memchr(p,'\n',end-p);
+  return newline ? newline : end;
+}
+
+// whether the text from p starts with the word "puzzle"
+static inline bool startsPuzzle(const char *p, const char *end) {
+  return end-p >= 6 && memcmp(p,"puzzle",6) == 0 && (end-p == 6 || isSpace(p[6]));
+}
+
+bool isPuzzleContainer(const char *begin, const char *end) {
+  while (begin < end && isSpace(*begin)) begin++;
+  return startsPuzzle(begin,end);
+}
+
+std::vector<PuzzleSpan> splitPuzzles(const char *begin, const char *end) {
+  std::vector<PuzzleSpan> spans;
+  if (!isPuzzleContainer(begin,end)) {
+    PuzzleSpan whole;
+    whole.begin = begin;
+    whole.end = end;
+    whole.line = 1;
+    spans.push_back(whole);
+    return spans;
+  }
+
+  // each line that starts with "puzzle" ends the puzzle before it and
+  // names the next one
+  int line = 1;
+  for (const char *p = begin; p < end; line++) {
+    const char *next = lineEnd(p,end);
+    const char *word = p;
+    while (word < next && (*word == ' ' || *word == '\t')) word++;
+    if (startsPuzzle(word,next)) {
+      if (!spans.empty()) spans.back().end = p;
+      const char *name = word + 6;
+      while (name < next && isSpace(*name)) name++;
+      const char *name_end = name;
+      while (name_end < next && !isSpace(*name_end)) name_end++;
+      PuzzleSpan span;
+      if (name == name_end) {
+        std::ostringstream number;
+        number << spans.size() + 1;
+        span.name = number.str();
+      } else {
+        span.name.assign(name,name_end);
+      }
+      span.begin = (next < end) ? next + 1 : end;
+      span.line = line + 1;
+      spans.push_back(span);
+    }
+    p = (next < end) ? next + 1 : end;
+  }
+  spans.back().end = end;
+  return spans;
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the PuzzleParser class
+
+PuzzleParser::PuzzleParser(const char *begin, const char *end, int line)
+  : text(begin), text_end(end), first_line(line), cursor(begin),
+    token_begin(begin), token_end(begin), error_line(0), error_column(0) {}
+
+PuzzleParser::PuzzleParser(const PuzzleSpan &span)
+  : text(span.begin), text_end(span.end), first_line(span.line), cursor(span.begin),
+    token_begin(span.begin), token_end(span.begin), error_line(0), error_column(0) {}
+
+bool PuzzleParser::nextToken() {
+  while (cursor < text_end && isSpace(*cursor)) cursor++;
+  token_begin = cursor;
+  while (cursor < text_end && !isSpace(*cursor)) cursor++;
+  token_end = cursor;
+  return token_begin < token_end;
+}
+
+bool PuzzleParser::tokenIs(const char *word) const {
+  size_t length = strlen(word);
+  return size_t(token_end - token_begin) == length && memcmp(token_begin,word,length) == 0;
+}
+
+// the next token as a whole number of at most max_value
+bool PuzzleParser::readNumber(long long max_value, long long &value) {
+  if (!nextToken()) return false;
+  value = 0;
+  for (const char *p = token_begin; p < token_end; p++) {
+    if (*p < '0' || *p > '9') return false;
+    value = value*10 + (*p - '0');
+    if (value > max_value) return false;
+  }
+  return true;
+}
+
+// the next token as a whole number plus one half (like 3.5), in half
+// units (7), of at most max_value half units
+bool PuzzleParser::readHalfUnit(long long max_value, long long &halves) {
+  if (!nextToken()) return false;
+  long long whole = 0;
+  const char *p = token_begin;
+  for (; p < token_end && *p >= '0' && *p <= '9'; p++) {
+    whole = whole*10 + (*p - '0');
+    if (2*whole > max_value) return false;
+  }
+  if (token_end - p < 2 || p[0] != '.' || p[1] != '5') return false;
+  for (p += 2; p < token_end; p++) {
+    if (*p != '0') return false;
+  }
+  halves = 2*whole + 1;
+  return halves <= max_value;
+}
+
+// the next token as a single character
+bool PuzzleParser::readName(char &name) {
+  if (!nextToken() || token_end - token_begin != 1) return false;
+  name = *token_begin;
+  return true;
+}
+
+// record an error at the current token (or at the end of the text if
+// the tokens ran out), working out the line and column only now
+bool PuzzleParser::fail(const std::string &message) {
+  error_line = first_line;
+  const char *line_start = text;
+  for (const char *p = text; p < token_begin; p++) {
+    if (*p == '\n') {
+      error_line++;
+      line_start = p + 1;
+    }
+  }
+  error_column = token_begin - line_start + 1;
+  error_message = message;
+  return false;
+}
+
+std::string PuzzleParser::error() const {
+  std::ostringstream ostr;
+  ostr << error_line << ":" << error_column << ": " << error_message;
+  return ostr.str();
+}
+
+bool PuzzleParser::parse(Board &board) {
+  cursor = text;
+
+  // read in the board dimensions and create an empty board
+  // (all outer edges are automatically set to be walls)
+  long long rows,cols;
+  if (!readNumber(Board::MAX_CELLS,rows) || !readNumber(Board::MAX_CELLS,cols) ||
+      rows < 1 || cols < 1 || rows*cols > Board::MAX_CELLS) {
+    return fail("the board dimensions are missing or out of range");
+  }
+  Board answer(rows,cols);
+  bool has_goal = false;
+
+  // read in the other characteristics of the puzzle board, checking
+  // everything the Board asserts about
+  while (nextToken()) {
+    if (tokenIs("robot")) {
+      char a;
+      if (!readName(a)) return fail("a robot needs a one letter name");
+      if (a < 'A' || a > 'Z') return fail(std::string("robot names must be capital letters, not ") + a);
+      for (unsigned int i = 0; i < answer.numRobots(); i++) {
+        if (answer.getRobot(i) == a) return fail(std::string("there are two robots named ") + a);
+      }
+      long long r,c;
+      if (!readNumber(rows,r) || r < 1 || !readNumber(cols,c) || c < 1) {
+        return fail(std::string("robot ") + a + " needs a row and a column on the board");
+      }
+      if (answer.getspot(Position(r,c)) != ' ' || (has_goal && answer.getGoal() == Position(r,c))) {
+        return fail(std::string("robot ") + a + " is on a cell that is already taken");
+      }
+      answer.placeRobot(Position(r,c),a);
+    } else if (tokenIs("vertical_wall")) {
+      long long i,j;
+      if (!readNumber(rows,i) || i < 1 || !readHalfUnit(2*cols,j)) {
+        return fail("a vertical wall needs a row and a column between two cells");
+      }
+      int edge = answer.verticalEdge(i,j);
+      if (answer.hasWall(edge)) {
+        return fail("a vertical wall is given twice (or is on the edge of the board)");
+      }
+      answer.addWall(edge);
+    } else if (tokenIs("horizontal_wall")) {
+      long long i,j;
+      if (!readHalfUnit(2*rows,i) || !readNumber(cols,j) || j < 1) {
+        return fail("a horizontal wall needs a row between two cells and a column");
+      }
+      int edge = answer.horizontalEdge(i,j);
+      if (answer.hasWall(edge)) {
+        return fail("a horizontal wall is given twice (or is on the edge of the board)");
+      }
+      answer.addWall(edge);
+    } else if (tokenIs("goal")) {
+      if (!nextToken()) return fail("the goal needs a robot (or any), a row and a column");
+      std::string which_robot(token_begin,token_end);
+      if (which_robot != "any") {
+        bool found = false;
+        for (unsigned int i = 0; i < answer.numRobots(); i++) {
+          if (which_robot.size() == 1 && answer.getRobot(i) == which_robot[0]) found = true;
+        }
+        if (!found) return fail("the goal robot " + which_robot + " does not exist");
+      }
+      long long r,c;
+      if (!readNumber(rows,r) || r < 1 || !readNumber(cols,c) || c < 1) {
+        return fail("the goal needs a row and a column on the board");
+      }
+      if (answer.getspot(Position(r,c)) != ' ') {
+        return fail("the goal is on a cell that is already taken");
+      }
+      answer.setGoal(which_robot,Position(r,c));
+      has_goal = true;
+    } else {
+      return fail("unknown token in the input file " + std::string(token_begin,token_end));
+    }
+  }
+  if (answer.numRobots() == 0 || !has_goal) {
+    return fail("a puzzle needs at least one robot and a goal");
+  }
+
+  board = std::move(answer);
+  return true;
+}
+
+
+// ==================================================================
+// ==================================================================
+// Reading a single puzzle
+
+bool parsePuzzle(const char *begin, const char *end, Board &board, std::string &error) {
+  std::vector<PuzzleSpan> spans = splitPuzzles(begin,end);
+  if (spans.size() != 1) {
+    std::ostringstream ostr;
+    ostr << "1:1: there are " << spans.size() << " puzzles instead of one";
+    error = ostr.str();
+    return false;
+  }
+  PuzzleParser parser(spans[0]);
+  if (!parser.parse(board)) {
+    error = parser.error();
+    return false;
+  }
+  return true;
+}
+
+bool loadPuzzle(const std::string &path, Board &board, std::string &error) {
+  MappedFile file;
+  if (!file.open(path)) {
+    error = "could not open " + path + " for reading";
+    return false;
+  }
+  if (!parsePuzzle(file.begin(),file.end(),board,error)) {
+    error = path + ":" + error;
+    return false;
+  }
+  return true;
+}
+
+Board readPuzzle(const std::string &path) {
+  Board answer(1,1);
+  std::string error;
+  if (!loadPuzzle(path,answer,error)) {
+    std::cerr << "ERROR: " << error << std::endl;
+    exit(0);
+  }
+  return answer;
+}
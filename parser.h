@@ -0,0 +1,129 @@
+#ifndef __PARSER_H__
+#define __PARSER_H__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "board.h"
+
+
+// ==================================================================
+// ==================================================================
+// A whole file in memory: memory mapped if it can be, and read in
+// otherwise (for pipes and the like).  The contents are not null
+// terminated.
+
+class MappedFile {
+public:
+  MappedFile() : data(NULL), length(0), mapped(false) {}
+  ~MappedFile() { close(); }
+
+  // returns false if the file can't be opened
+  bool open(const std::string &path);
+  void close();
+
+  const char* begin() const { return data; }
+  const char* end() const { return data + length; }
+  size_t size() const { return length; }
+
+private:
+  // the mapping can't be shared between two MappedFiles
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  const char *data;
+  size_t length;
+  bool mapped;
+  // the contents, if they couldn't be mapped
+  std::string contents;
+};
+
+
+// ==================================================================
+// ==================================================================
+// One puzzle in a buffer.  A puzzle file holds a single puzzle, with no
+// name.  A container file holds any number of them, each one starting
+// with a line "puzzle <name>" followed by the puzzle in the usual
+// format, like
+//
+//   puzzle first
+//   4 4
+//   robot A 1 1
+//   goal A 4 4
+//   puzzle second
+//   ...
+
+class PuzzleSpan {
+public:
+  std::string name;
+  const char *begin;
+  const char *end;
+  // the line of the buffer the puzzle text starts on (from 1)
+  int line;
+};
+
+// whether a buffer is a container (its first word is "puzzle")
+bool isPuzzleContainer(const char *begin, const char *end);
+// split a buffer into its puzzles (a single unnamed one if it isn't a
+// container, and a puzzle with no name in a container is named by its
+// number, from 1)
+std::vector<PuzzleSpan> splitPuzzles(const char *begin, const char *end);
+
+
+// ==================================================================
+// ==================================================================
+// Parses and checks the text of one puzzle straight from a buffer,
+// without copying it or allocating anything per token.  The walls are
+// read as whole numbers of half units, so no floating point parsing is
+// needed.  Everything the Board would assert about is checked, and the
+// first problem is reported with the line and column where it is.
+
+class PuzzleParser {
+public:
+  // the text from begin to end, which starts on line first_line
+  PuzzleParser(const char *begin, const char *end, int first_line=1);
+  PuzzleParser(const PuzzleSpan &span);
+
+  // parse the puzzle into board (returns false if it isn't valid)
+  bool parse(Board &board);
+
+  // where the error was and what it was, like "3:14: robot A is off
+  // the board"
+  std::string error() const;
+
+private:
+  // the tokens: the next one is from token_begin to token_end
+  bool nextToken();
+  bool tokenIs(const char *word) const;
+  bool readNumber(long long max_value, long long &value);
+  bool readHalfUnit(long long max_value, long long &halves);
+  bool readName(char &name);
+  bool fail(const std::string &message);
+
+  const char *text;
+  const char *text_end;
+  int first_line;
+  const char *cursor;
+  const char *token_begin;
+  const char *token_end;
+
+  int error_line;
+  int error_column;
+  std::string error_message;
+};
+
+
+// ==================================================================
+// ==================================================================
+// Reading a single puzzle: from a buffer that holds one puzzle (or a
+// container of just one) into board, returning false with a description
+// of the problem in error, like "3:14: robot A is off the board", if it
+// isn't valid
+bool parsePuzzle(const char *begin, const char *end, Board &board, std::string &error);
+// the same from a puzzle file (the error starts with the file name)
+bool loadPuzzle(const std::string &path, Board &board, std::string &error);
+// the same, but exiting with an error message on an invalid puzzle
+Board readPuzzle(const std::string &path);
+
+#endif
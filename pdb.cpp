@@ -0,0 +1,134 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pdb.h"
+#include "board.h"
+
+
+// ==================================================================
+// ==================================================================
+// The file is a 24 byte header:
+//
+//   8 bytes   the magic string "RRPDB001"
+//   8 bytes   the layout hash (Board::geometryHash)
+//   4 bytes   the number of cells
+//   4 bytes   unused
+//
+// followed by the table, indexed by goal cell * cells + helper cell.
+
+static const char MAGIC[8] = { 'R','R','P','D','B','0','0','1' };
+static const size_t HEADER_BYTES = 24;
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the PatternDatabase class
+
+PatternDatabase::PatternDatabase() : layout(0), num_cells(0), table(NULL),
+                                     mapping(NULL), length(0) {}
+
+PatternDatabase::~PatternDatabase() {
+  close();
+}
+
+// A breadth first search backwards from every placement with the goal
+// robot on the goal.  Either robot of a placement may have got where it
+// is from any cell behind it, up to a wall or the other robot, since
+// some robot outside the pattern may have stopped it there.
+void PatternDatabase::build(const Board &board) {
+  static const int dr[4] = { -1, 1, 0, 0 };
+  static const int dc[4] = { 0, 0, 1, -1 };
+  close();
+  int cols = board.getCols();
+  num_cells = board.getRows() * cols;
+  assert (num_cells <= MAX_CELLS);
+  layout = board.geometryHash();
+  built.assign(num_cells*num_cells, (unsigned char)UNREACHABLE);
+  table = &built[0];
+
+  int goal_cell = (board.getGoal().row-1)*cols + board.getGoal().col-1;
+  std::vector<int> queue;
+  for (int helper = 0; helper < num_cells; helper++) {
+    if (helper == goal_cell) continue;
+    built[goal_cell*num_cells + helper] = 0;
+    queue.push_back(goal_cell*num_cells + helper);
+  }
+  for (unsigned int q = 0; q < queue.size(); q++) {
+    int goal_robot = queue[q] / num_cells;
+    int helper = queue[q] % num_cells;
+    int moves = built[queue[q]] + 1;
+    if (moves >= UNREACHABLE) continue;
+    for (int which = 0; which < 2; which++) {
+      int cell = (which == 0) ? goal_robot : helper;
+      int other = (which == 0) ? helper : goal_robot;
+      for (int d = NORTH; d <= WEST; d++) {
+        int stop = board.slideStop(cell,d);
+        for (int from = cell; from != stop; ) {
+          from += dr[d]*cols + dc[d];
+          if (from == other) break;
+          int placement = (which == 0) ? from*num_cells + helper : goal_robot*num_cells + from;
+          if (built[placement] != UNREACHABLE) continue;
+          built[placement] = moves;
+          queue.push_back(placement);
+        }
+      }
+    }
+  }
+}
+
+bool PatternDatabase::write(const std::string &filename) const {
+  assert (isOpen());
+  std::ofstream ostr(filename.c_str(), std::ios::binary);
+  if (!ostr) return false;
+  char header[HEADER_BYTES];
+  memset(header,0,HEADER_BYTES);
+  memcpy(header,MAGIC,8);
+  memcpy(header+8,&layout,8);
+  uint32_t cells = num_cells;
+  memcpy(header+16,&cells,4);
+  ostr.write(header,HEADER_BYTES);
+  ostr.write((const char*)table,(size_t)num_cells*num_cells);
+  return ostr.good();
+}
+
+bool PatternDatabase::open(const std::string &filename, const Board &board) {
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat info;
+  if (fstat(fd,&info) != 0 || info.st_size < (off_t)HEADER_BYTES) {
+    ::close(fd);
+    return false;
+  }
+  length = info.st_size;
+  mapping = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = NULL;
+    return false;
+  }
+  const char *header = (const char*)mapping;
+  uint32_t cells;
+  memcpy(&layout, header+8, 8);
+  memcpy(&cells, header+16, 4);
+  num_cells = cells;
+  if (memcmp(header,MAGIC,8) != 0 || layout != board.geometryHash() ||
+      num_cells != board.getRows()*board.getCols() ||
+      length != HEADER_BYTES + (size_t)num_cells*num_cells) {
+    close();
+    return false;
+  }
+  table = (const unsigned char*)mapping + HEADER_BYTES;
+  return true;
+}
+
+void PatternDatabase::close() {
+  if (mapping != NULL) munmap(mapping,length);
+  mapping = NULL;
+  table = NULL;
+  built.clear();
+}
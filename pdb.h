@@ -0,0 +1,70 @@
+#ifndef __PDB_H__
+#define __PDB_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class Board;
+
+
+// ==================================================================
+// ==================================================================
+// A pattern database for one layout (board, walls and goal): for every
+// placement of the goal robot and one other "helper" robot, the fewest
+// moves needed to bring the goal robot to the goal.
+//
+// The robots that aren't in the pattern could be anywhere, and any of
+// them could stop a moving robot, so in the pattern a move may end in
+// any cell before the next wall or the other pattern robot.  That keeps
+// the count a lower bound on the real number of moves (moving the
+// other robots is free in the pattern), so the largest count over the
+// helpers is an admissible estimate for iterative deepening.  It is at
+// least the single robot goal distance, and more wherever a helper is
+// in the way.
+//
+// The database takes one byte per pair of cells, so it is only built
+// for boards of up to MAX_CELLS cells.  It is built once per layout by
+// the separate pdbgen program and memory mapped by the solver.
+
+class PatternDatabase {
+public:
+  static const int MAX_CELLS = 1024;
+  // the value stored for placements that can never be solved
+  static const int UNREACHABLE = 255;
+
+  PatternDatabase();
+  ~PatternDatabase();
+
+  // compute the database for the layout of board (which must have its
+  // slide stops computed)
+  void build(const Board &board);
+  // save the database to a file, returns false if it can't be written
+  bool write(const std::string &filename) const;
+  // memory map a database file, returns false (leaving the database
+  // closed) if it can't be read or was built for a different layout
+  bool open(const std::string &filename, const Board &board);
+  void close();
+  bool isOpen() const { return table != NULL; }
+
+  // the fewest moves to bring the goal robot from one cell to the goal
+  // with the helper starting in another (cells row major, from 0)
+  int distance(int goal_cell, int helper_cell) const {
+    return table[goal_cell*num_cells + helper_cell];
+  }
+
+private:
+  // the table can't be shared between two databases
+  PatternDatabase(const PatternDatabase&);
+  PatternDatabase& operator=(const PatternDatabase&);
+
+  uint64_t layout;
+  int num_cells;
+  // the table, either in built or in the mapped file
+  std::vector<unsigned char> built;
+  const unsigned char *table;
+  void *mapping;
+  size_t length;
+};
+
+#endif
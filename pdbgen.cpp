@@ -0,0 +1,42 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "board.h"
+#include "parser.h"
+#include "pdb.h"
+
+// ================================================================
+// ================================================================
+// Builds the pattern database for the layout of a puzzle file (see
+// pdb.h), to be passed to the solver with -pdb.  Any puzzle with the
+// same board, walls and goal can use the same database, wherever its
+// robots are.
+
+int main(int argc, char* argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <puzzle_file> <database_file>" << std::endl;
+    exit(1);
+  }
+
+  Board board(1,1);
+  std::string error;
+  if (!loadPuzzle(argv[1],board,error)) {
+    std::cerr << "ERROR: " << error << std::endl;
+    exit(1);
+  }
+  board.computeSlideStops();
+  if (board.getRows() * board.getCols() > PatternDatabase::MAX_CELLS) {
+    std::cerr << "ERROR: pattern databases are only built for boards of up to "
+              << PatternDatabase::MAX_CELLS << " cells" << std::endl;
+    exit(1);
+  }
+
+  PatternDatabase pdb;
+  pdb.build(board);
+  if (!pdb.write(argv[2])) {
+    std::cerr << "ERROR: could not write " << argv[2] << std::endl;
+    exit(1);
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <cassert>
+#include <thread>
+#include "pool.h"
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the WorkStealingPool class
+
+WorkStealingPool::WorkStealingPool(int workers)
+  : queues(workers), locks(workers), current(NULL), runs(0), busy(0), stopping(false) {
+  assert (workers >= 1);
+  num_workers = workers;
+  for (int w = 1; w < num_workers; w++) {
+    threads.push_back(std::thread(&WorkStealingPool::work,this,w));
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> guard(control);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (unsigned int t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+}
+
+void WorkStealingPool::run(int num_tasks, const std::function<void(int,int)> &task) {
+  // hand out contiguous shares of the tasks (the other threads are all
+  // waiting, so the queues are ours)
+  for (int w = 0; w < num_workers; w++) {
+    int first = (long long)num_tasks * w / num_workers;
+    int last = (long long)num_tasks * (w+1) / num_workers;
+    queues[w].clear();
+    for (int i = first; i < last; i++) {
+      queues[w].push_back(i);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(control);
+    current = &task;
+    busy = num_workers - 1;
+    runs++;
+  }
+  wake.notify_all();
+  for (int i = next(0); i != -1; i = next(0)) {
+    task(0,i);
+  }
+  std::unique_lock<std::mutex> lock(control);
+  finished.wait(lock, [this]() { return busy == 0; });
+  current = NULL;
+}
+
+void WorkStealingPool::work(int worker) {
+  unsigned long long seen = 0;
+  while (true) {
+    const std::function<void(int,int)> *task;
+    {
+      std::unique_lock<std::mutex> lock(control);
+      wake.wait(lock, [&]() { return stopping || runs != seen; });
+      if (stopping) return;
+      seen = runs;
+      task = current;
+    }
+    for (int i = next(worker); i != -1; i = next(worker)) {
+      (*task)(worker,i);
+    }
+    std::lock_guard<std::mutex> guard(control);
+    if (--busy == 0) finished.notify_one();
+  }
+}
+
+int WorkStealingPool::next(int worker) {
+  {
+    std::lock_guard<std::mutex> guard(locks[worker]);
+    if (!queues[worker].empty()) {
+      int i = queues[worker].front();
+      queues[worker].pop_front();
+      return i;
+    }
+  }
+  // our own queue is empty, so steal from the others (from the back,
+  // the tasks their owners would get to last)
+  for (int k = 1; k < num_workers; k++) {
+    int victim = (worker + k) % num_workers;
+    std::lock_guard<std::mutex> guard(locks[victim]);
+    if (!queues[victim].empty()) {
+      int i = queues[victim].back();
+      queues[victim].pop_back();
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,65 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+
+// ==================================================================
+// ==================================================================
+// Runs a numbered set of independent tasks on a fixed number of worker
+// threads.  Each worker starts with a contiguous share of the tasks
+// and takes them from the front of its own queue; once it runs out it
+// steals from the back of another worker's queue.  The tasks can take
+// wildly different amounts of time, and stealing keeps every worker
+// busy until the very end.
+//
+// The threads are started once, with the pool, and wait between runs,
+// so a pool can run many small batches of tasks cheaply.  The thread
+// that calls run is worker 0.
+
+class WorkStealingPool {
+public:
+  WorkStealingPool(int workers);
+  ~WorkStealingPool();
+
+  int numWorkers() const { return num_workers; }
+
+  // call task(worker,i) for every i from 0 to num_tasks-1 and return
+  // once they have all finished (worker is the id of the thread
+  // running the task, from 0 to numWorkers()-1)
+  void run(int num_tasks, const std::function<void(int,int)> &task);
+
+private:
+  // the pool owns its threads
+  WorkStealingPool(const WorkStealingPool&);
+  WorkStealingPool& operator=(const WorkStealingPool&);
+
+  // the next task for a worker, its own or a stolen one (-1 if none
+  // are left anywhere)
+  int next(int worker);
+  // what each thread (workers 1 and up) does until the pool goes away
+  void work(int worker);
+
+  int num_workers;
+  std::vector<std::deque<int> > queues;
+  std::vector<std::mutex> locks;
+  std::vector<std::thread> threads;
+
+  // the current run, guarded by control: the task, a count of the runs
+  // so far (so a thread knows when there is a new one), and the threads
+  // still working on it
+  std::mutex control;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  const std::function<void(int,int)> *current;
+  unsigned long long runs;
+  int busy;
+  bool stopping;
+};
+
+#endif
@@ -0,0 +1,255 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <dirent.h>
+
+#include "board.h"
+#include "solver.h"
+#include "pool.h"
+
+// ================================================================
+// ================================================================
+// Generates random puzzles whose optimal solution takes a chosen number
+// of moves, for building large corpora to benchmark or stress the
+// solver with.  The same seed and parameters always give the same
+// puzzles (puzzle i only depends on the seed and i, so any one of them
+// can be made again on its own).
+//
+// Each puzzle is made by drawing a board (interior walls, each present
+// with the given density, and the robots on distinct cells), then
+// computing the accessibility map of the goal robot (or of any robot)
+// up to the target number of moves, and putting the goal on one of the
+// cells first reached at exactly that many moves (and not taken by a
+// robot).  The puzzle is then solved to check the length.  Boards with
+// no such cell are redrawn.
+// The puzzles are made on all the cores at once (or -threads of them),
+// and written one per file in a directory (-out) or all together in
+// a container file (-container, see parser.h), named by their number.
+
+bool usage(const std::string &executable_name) {
+  std::cerr << "Usage: " << executable_name << " -moves <#> [-rows <#>] [-cols <#>] [-robots <#>]" << std::endl;
+  std::cerr << "       [-walls <density>] [-goal_robot] [-seed <#>]" << std::endl;
+  std::cerr << "       [-count <#> (-out <directory> | -container <file>)]" << std::endl;
+  std::cerr << "       [-threads <#>]" << std::endl;
+  exit(1);
+}
+
+
+// the generator's own random numbers, from raw 64 bit values (the
+// standard distributions are allowed to differ between libraries, which
+// would change the puzzles)
+class PuzzleRandom {
+public:
+  PuzzleRandom(unsigned long long seed, unsigned long long index)
+    : engine(seed * 0x9E3779B97F4A7C15ULL + index) {}
+  // a whole number from 0 to n-1
+  int below(int n) { return engine() % n; }
+  // true with probability p
+  bool chance(double p) { return (engine() >> 11) * (1.0 / 9007199254740992.0) < p; }
+private:
+  std::mt19937_64 engine;
+};
+
+
+// Draw a board with walls and robots and no goal yet
+Board randomBoard(PuzzleRandom &random, int rows, int cols, int num_robots, double density) {
+  Board board(rows,cols);
+  for (int r = 1; r <= rows; r++) {
+    for (int c = 1; c < cols; c++) {
+      if (random.chance(density)) board.addWall(board.verticalEdge(r,2*c+1));
+    }
+  }
+  for (int r = 1; r < rows; r++) {
+    for (int c = 1; c <= cols; c++) {
+      if (random.chance(density)) board.addWall(board.horizontalEdge(2*r+1,c));
+    }
+  }
+  // the robots go on distinct cells, from a partial shuffle
+  std::vector<int> cells(rows*cols);
+  for (int i = 0; i < rows*cols; i++) cells[i] = i;
+  for (int i = 0; i < num_robots; i++) {
+    int j = i + random.below(rows*cols - i);
+    std::swap(cells[i],cells[j]);
+    board.placeRobot(Position(cells[i]/cols + 1, cells[i]%cols + 1), 'A' + i);
+  }
+  // a placeholder goal until the real one is picked
+  board.setGoal("any",Position(1,1));
+  board.computeSlideStops();
+  return board;
+}
+
+// Make puzzle number index: keep drawing boards until one has a cell
+// that takes exactly moves moves to reach (false if none of max_attempts
+// boards does)
+bool generate(Solver &solver, long long mem_limit, unsigned long long seed,
+              unsigned long long index, int rows, int cols, int num_robots,
+              double density, int moves, bool goal_robot, int max_attempts, Board &puzzle) {
+  PuzzleRandom random(seed,index);
+  for (int attempt = 0; attempt < max_attempts; attempt++) {
+    Board board = randomBoard(random,rows,cols,num_robots,density);
+    int robot = goal_robot ? random.below(num_robots) : -1;
+
+    SolverOptions options;
+    options.accessibility = true;
+    options.per_robot = goal_robot;
+    options.max_moves = moves;
+    options.mem_limit = mem_limit;
+    SolverResult result = solver.solve(board,options);
+    const Grid<int> &viz =
+      goal_robot ? result.robot_accessibility[robot] : result.accessibility;
+
+    std::vector<Position> candidates;
+    for (int r = 1; r <= rows; r++) {
+      for (int c = 1; c <= cols; c++) {
+        // the goal can't be on a cell a robot starts on
+        if (viz[r][c] == moves && board.getspot(Position(r,c)) == ' ') {
+          candidates.push_back(Position(r,c));
+        }
+      }
+    }
+    if (candidates.empty()) continue;
+    Position goal = candidates[random.below(candidates.size())];
+    board.setGoal(goal_robot ? std::string(1,board.getRobot(robot)) : std::string("any"), goal);
+    board.computeSlideStops();
+
+    // check the length with the solver itself
+    SolverOptions check;
+    check.max_moves = moves;
+    check.mem_limit = mem_limit;
+    SolverResult solved = solver.solve(board,check);
+    if (solved.moves != moves) {
+      std::cerr << "ERROR: puzzle " << index << " takes " << solved.moves
+                << " moves instead of " << moves << std::endl;
+      exit(1);
+    }
+    puzzle = board;
+    return true;
+  }
+  return false;
+}
+
+
+// ================================================================
+// ================================================================
+
+int main(int argc, char* argv[]) {
+  int rows = 8;
+  int cols = 8;
+  int num_robots = 4;
+  double density = 0.1;
+  int moves = -1;
+  bool goal_robot = false;
+  unsigned long long seed = 1;
+  int count = 1;
+  std::string out;
+  std::string container;
+  int threads = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-goal_robot") {
+      goal_robot = true;
+      continue;
+    }
+    i++;
+    if (i >= argc) usage(argv[0]);
+    if (arg == "-rows") {
+      rows = atoi(argv[i]);
+    } else if (arg == "-cols") {
+      cols = atoi(argv[i]);
+    } else if (arg == "-robots") {
+      num_robots = atoi(argv[i]);
+    } else if (arg == "-walls") {
+      density = atof(argv[i]);
+    } else if (arg == "-moves") {
+      moves = atoi(argv[i]);
+    } else if (arg == "-seed") {
+      seed = strtoull(argv[i],NULL,10);
+    } else if (arg == "-count") {
+      count = atoi(argv[i]);
+    } else if (arg == "-out") {
+      out = argv[i];
+    } else if (arg == "-container") {
+      container = argv[i];
+    } else if (arg == "-threads") {
+      threads = atoi(argv[i]);
+      if (threads < 1) usage(argv[0]);
+    } else {
+      std::cerr << "ERROR: unknown argument " << arg << std::endl;
+      usage(argv[0]);
+    }
+  }
+  if (rows < 1 || cols < 1 || num_robots < 1 || num_robots > Board::MAX_ROBOTS ||
+      (long long)rows*cols > Board::MAX_CELLS || num_robots >= rows*cols ||
+      density < 0 || density > 1 || moves < 1 || moves > Solver::MAX_MOVES || count < 1) {
+    usage(argv[0]);
+  }
+  // several puzzles need a directory or a container to put them in
+  if ((count > 1 && out.empty() && container.empty()) || (!out.empty() && !container.empty())) {
+    usage(argv[0]);
+  }
+  std::ofstream container_ostr;
+  if (!container.empty()) {
+    container_ostr.open(container.c_str());
+    if (!container_ostr) {
+      std::cerr << "ERROR: could not open " << container << " for writing" << std::endl;
+      exit(1);
+    }
+  }
+  if (!out.empty()) {
+    DIR *dir = opendir(out.c_str());
+    if (dir == NULL) {
+      std::cerr << "ERROR: " << out << " is not a directory" << std::endl;
+      exit(1);
+    }
+    closedir(dir);
+  }
+
+  // each worker keeps its own Solver, and they share the default
+  // memory budget
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads,count);
+  long long mem_limit = SolverOptions().mem_limit / threads;
+  WorkStealingPool pool(threads);
+  std::vector<Solver> solvers(threads);
+  // the puzzles of a container are written in order at the end
+  std::vector<std::string> texts(container.empty() ? 0 : count);
+
+  pool.run(count, [&](int worker, int i) {
+    Board puzzle(rows,cols);
+    if (!generate(solvers[worker],mem_limit,seed,i,rows,cols,num_robots,density,moves,
+                  goal_robot,1000,puzzle)) {
+      std::cerr << "ERROR: could not make a puzzle that takes " << moves << " moves" << std::endl;
+      exit(1);
+    }
+    std::ostringstream name;
+    name << "puzzle_" << seed << "_" << std::setw(6) << std::setfill('0') << i;
+    if (!container.empty()) {
+      std::ostringstream text;
+      text << "puzzle " << name.str() << std::endl;
+      writePuzzle(text,puzzle);
+      texts[i] = text.str();
+      return;
+    }
+    if (out.empty()) {
+      writePuzzle(std::cout,puzzle);
+      return;
+    }
+    std::string file = out + "/" + name.str() + ".txt";
+    std::ofstream ostr(file.c_str());
+    if (!ostr) {
+      std::cerr << "ERROR: could not open " << file << " for writing" << std::endl;
+      exit(1);
+    }
+    writePuzzle(ostr,puzzle);
+  });
+  for (unsigned int i = 0; i < texts.size(); i++) container_ostr << texts[i];
+  return 0;
+}
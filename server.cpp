@@ -0,0 +1,233 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "parser.h"
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the GeometryCache class
+
+size_t GeometryCache::Entry::memory() const {
+  return board.memory() + goals.size()*board.getRows()*board.getCols()*sizeof(int);
+}
+
+std::shared_ptr<const std::vector<int> > GeometryCache::prepare(Board &board) {
+  uint64_t hash = board.wallHash();
+  Position goal = board.getGoal();
+  int goal_cell = (goal.row-1)*board.getCols() + goal.col-1;
+  bool known = false;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    std::unordered_map<uint64_t,Entries::iterator>::iterator found = index.find(hash);
+    if (found != index.end() && found->second->board.sameWalls(board)) {
+      // move it to the front, as the most recently used
+      entries.splice(entries.begin(),entries,found->second);
+      board.copySlideStops(entries.front().board);
+      std::unordered_map<int,std::shared_ptr<const std::vector<int> > >::iterator distances =
+        entries.front().goals.find(goal_cell);
+      if (distances != entries.front().goals.end()) return distances->second;
+      known = true;
+    }
+  }
+
+  // compute what is missing without holding the lock, then add it
+  if (!known) board.computeSlideStops();
+  std::shared_ptr<std::vector<int> > distances(new std::vector<int>());
+  computeGoalDistances(board,*distances);
+  size_t distance_bytes = distances->size()*sizeof(int);
+  std::lock_guard<std::mutex> guard(lock);
+  std::unordered_map<uint64_t,Entries::iterator>::iterator found = index.find(hash);
+  if (found != index.end() && !found->second->board.sameWalls(board)) {
+    // another geometry has the same hash, and is replaced
+    bytes -= found->second->memory();
+    entries.erase(found->second);
+    index.erase(found);
+    found = index.end();
+  }
+  if (found == index.end()) {
+    // (it may have been evicted meanwhile)
+    entries.push_front(Entry(hash,board));
+    index[hash] = entries.begin();
+    bytes += board.memory();
+  } else {
+    entries.splice(entries.begin(),entries,found->second);
+  }
+  // another thread may have added the same goal meanwhile
+  std::shared_ptr<const std::vector<int> > &slot = entries.front().goals[goal_cell];
+  if (!slot) {
+    slot = distances;
+    bytes += distance_bytes;
+  }
+  std::shared_ptr<const std::vector<int> > answer = slot;
+  evict();
+  return answer;
+}
+
+// Drop the least recently used geometries until the cache fits (never
+// the most recent one)
+void GeometryCache::evict() {
+  while (entries.size() > 1 && ((int)entries.size() > max_entries || bytes > MAX_BYTES)) {
+    bytes -= entries.back().memory();
+    index.erase(entries.back().hash);
+    entries.pop_back();
+  }
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the SolverServer class
+
+SolverServer::SolverServer(const std::string &socket_path, const SolverOptions &o,
+                           int workers, int queue_length, int geometries)
+  : path(socket_path), options(o), num_workers(workers), max_queue(queue_length),
+    geometry(geometries) {
+  assert (workers >= 1 && queue_length >= 1 && geometries >= 1);
+}
+
+// write all of text to a connection (giving up if the client is gone)
+static void writeAll(int fd, const std::string &text) {
+  size_t done = 0;
+  while (done < text.size()) {
+    ssize_t n = write(fd, text.data() + done, text.size() - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    done += n;
+  }
+}
+
+bool SolverServer::run() {
+  // a client that hangs up early must not stop the server
+  signal(SIGPIPE,SIG_IGN);
+
+  struct sockaddr_un addr;
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "ERROR: the socket path " << path << " is too long" << std::endl;
+    return false;
+  }
+  strcpy(addr.sun_path,path.c_str());
+  int listener = socket(AF_UNIX,SOCK_STREAM,0);
+  // a socket left behind by an earlier server is replaced
+  unlink(path.c_str());
+  if (listener < 0 || bind(listener,(struct sockaddr*)&addr,sizeof(addr)) != 0 ||
+      listen(listener,max_queue) != 0) {
+    std::cerr << "ERROR: could not listen on " << path << ": " << strerror(errno) << std::endl;
+    if (listener >= 0) close(listener);
+    return false;
+  }
+
+  // the workers share the memory budget
+  options.mem_limit /= num_workers;
+  std::vector<Solver> solvers(num_workers);
+  std::vector<std::thread> workers;
+  for (int w = 0; w < num_workers; w++) {
+    workers.push_back(std::thread(&SolverServer::work,this,std::ref(solvers[w])));
+  }
+
+  while (true) {
+    int client = accept(listener,NULL,NULL);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      std::cerr << "ERROR: accept failed: " << strerror(errno) << std::endl;
+      break;
+    }
+    struct timeval timeout;
+    timeout.tv_sec = CLIENT_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(client,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+    setsockopt(client,SOL_SOCKET,SO_SNDTIMEO,&timeout,sizeof(timeout));
+
+    std::unique_lock<std::mutex> guard(lock);
+    if (queue.size() >= max_queue) {
+      guard.unlock();
+      writeAll(client,"ERROR: the server is busy\n");
+      close(client);
+      continue;
+    }
+    queue.push_back(client);
+    guard.unlock();
+    ready.notify_one();
+  }
+
+  // stop the workers once the queue is empty
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    queue.push_back(-1);
+  }
+  ready.notify_all();
+  for (int w = 0; w < num_workers; w++) workers[w].join();
+  close(listener);
+  unlink(path.c_str());
+  return false;
+}
+
+// A worker: answer the connections on the queue one at a time, until
+// it holds -1 (which is left there for the other workers)
+void SolverServer::work(Solver &solver) {
+  while (true) {
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this]() { return !queue.empty(); });
+    int client = queue.front();
+    if (client == -1) return;
+    queue.pop_front();
+    guard.unlock();
+
+    // the request is everything the client sends before closing its
+    // side of the connection
+    std::string request;
+    char buffer[4096];
+    bool complete = false;
+    while (request.size() <= MAX_REQUEST) {
+      ssize_t n = read(client,buffer,sizeof(buffer));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        complete = (n == 0);
+        break;
+      }
+      request.append(buffer,n);
+    }
+    if (!complete) {
+      writeAll(client,"ERROR: the request is too long or was not finished\n");
+    } else {
+      writeAll(client,answer(solver,request));
+    }
+    close(client);
+  }
+}
+
+// Solve the puzzle of one request and format the line sent back
+std::string SolverServer::answer(Solver &solver, const std::string &request) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Board board(1,1);
+  std::string error;
+  if (!parsePuzzle(request.data(),request.data()+request.size(),board,error)) {
+    return "ERROR: " + error + "\n";
+  }
+  SolverOptions request_options = options;
+  request_options.goal_distances = geometry.prepare(board);
+  SolverResult result = solver.solve(board,request_options);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::ostringstream line;
+  if (result.paths.empty()) {
+    line << "- -";
+  } else {
+    line << result.moves << " " << pathText(board,result.paths[0]);
+  }
+  line << " " << result.expanded << " " << std::fixed << std::setprecision(6) << seconds << std::endl;
+  return line.str();
+}
@@ -0,0 +1,112 @@
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+#include <string>
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <stdint.h>
+
+#include "board.h"
+#include "solver.h"
+
+
+// ==================================================================
+// ==================================================================
+// A least recently used cache of boards with their slide stops
+// computed, one per geometry (board size and walls), so that a puzzle
+// on a geometry that was seen recently takes the slide stops from the
+// cache instead of computing them again.  Each geometry also keeps the
+// goal distances (see computeGoalDistances) of every goal it has been
+// asked for.  It holds at most capacity geometries and MAX_BYTES of
+// boards and goal distances (a board of a million cells takes about
+// 20MB, and its goal distances 4MB).  Safe to use from any number of
+// threads at once.
+
+class GeometryCache {
+public:
+  static const size_t MAX_BYTES = size_t(256) << 20;
+
+  GeometryCache(int capacity) : max_entries(capacity), bytes(0) {}
+
+  // give board its slide stops and return the goal distances of its
+  // goal, from the cache if they are there (and otherwise computing them
+  // and adding them)
+  std::shared_ptr<const std::vector<int> > prepare(Board &board);
+
+private:
+  // a geometry: its wall hash, the board with its slide stops and the
+  // goal distances by goal cell
+  class Entry {
+  public:
+    Entry(uint64_t h, const Board &b) : hash(h), board(b) {}
+    // the bytes it takes
+    size_t memory() const;
+    uint64_t hash;
+    Board board;
+    std::unordered_map<int,std::shared_ptr<const std::vector<int> > > goals;
+  };
+  typedef std::list<Entry> Entries;
+
+  void evict();
+
+  int max_entries;
+  size_t bytes;
+  std::mutex lock;
+  // the geometries by wall hash, the most recently used first
+  Entries entries;
+  std::unordered_map<uint64_t,Entries::iterator> index;
+};
+
+
+// ==================================================================
+// ==================================================================
+// A long running solver that answers requests on a Unix domain socket.
+// A client connects, writes a puzzle (in the same format as a puzzle
+// file), closes its side of the connection and reads back one line:
+//   <# of moves> <solution> <configurations expanded> <seconds>
+// as in batch mode ("-" for the moves and solution if there is none),
+// or "ERROR: <description>" if the puzzle isn't valid.
+//
+// The connections are put on a queue of bounded length and answered by
+// a fixed pool of worker threads.  Each worker keeps its own Solver, so
+// the search tables stay allocated from one request to the next, and
+// the slide stops and goal distances of recently seen geometries are
+// shared through a GeometryCache.  A client that arrives while the queue is full is told
+// the server is busy.
+
+class SolverServer {
+public:
+  SolverServer(const std::string &socket_path, const SolverOptions &options,
+               int workers, int queue_length, int geometries);
+
+  // serve requests until the process is stopped (returns false, with a
+  // message on stderr, if the socket can't be set up)
+  bool run();
+
+private:
+  void work(Solver &solver);
+  std::string answer(Solver &solver, const std::string &request);
+
+  // the longest request that is read (enough for the walls of the
+  // biggest boards), and how long a client may take to send it
+  static const size_t MAX_REQUEST = 32 << 20;
+  static const int CLIENT_TIMEOUT = 10;
+
+  std::string path;
+  SolverOptions options;
+  int num_workers;
+  unsigned int max_queue;
+  GeometryCache geometry;
+
+  // the accepted connections waiting for a worker
+  std::mutex lock;
+  std::condition_variable ready;
+  std::deque<int> queue;
+};
+
+#endif
@@ -0,0 +1,1319 @@
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include "solver.h"
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the Solver class
+
+
+SolverResult Solver::solve(const Board &b, const SolverOptions &o) {
+  assert (o.threads >= 1);
+  SolverResult answer;
+  board = &b;
+  options = o;
+  result = &answer;
+  num_robots = board->numRobots();
+  goal = board->getGoal();
+  goal_robot = board->getGoalRobot();
+  out_of_memory = false;
+  streaming = false;
+  cache_bound = -1;
+  cache_stored = false;
+  chooseLayerExpansion();
+  if (!options.cache_dir.empty() && !options.accessibility) {
+    StateCodec layout_codec(board->getRows(),board->getCols(),num_robots,goal_robot);
+    cache.open(options.cache_dir,*board,layout_codec.words(),options.cache_size);
+  }
+
+  if (options.accessibility) {
+    solveAccessibility();
+  } else if (options.ida) {
+    solveIDA(1);
+  } else if (options.bidirectional && goal_robot != -1 &&
+             board->getRobotPositions()[goal_robot] != goal) {
+    solveBidirectional();
+  } else {
+    solveBFS();
+  }
+  cache.close();
+  pdb.close();
+  answer.stats.cell_bits = codec.cellBits();
+  answer.stats.key_words = codec.words();
+
+  board = NULL;
+  result = NULL;
+  return answer;
+}
+
+// the deepest any search goes
+int Solver::moveLimit() const {
+  int limit = (options.max_moves == -1) ? MAX_MOVES : options.max_moves;
+  if (limit > MAX_MOVES) limit = MAX_MOVES;
+  return limit;
+}
+
+// Check whether the hash tables and layers of the breadth first
+// searches have used up the memory budget (a table needs three times
+// its size while it doubles, so that much is counted).  Once they have,
+// out_of_memory stays set for the rest of the solve.
+bool Solver::overMemoryLimit() {
+  size_t layers = frontier.capacity() + next_frontier.capacity();
+  size_t used = 3*depths.memory() + layers*sizeof(uint64_t);
+  // the partial configurations of the bidirectional search, and roughly
+  // what their index takes
+  used += patterns.capacity()*sizeof(PartialConfiguration) +
+    patterns.size()*sizeof(unsigned int) + pattern_index.size()*64;
+  if ((long long)used > options.mem_limit) out_of_memory = true;
+  return out_of_memory;
+}
+
+// Give the memory of the breadth first searches back to the system
+void Solver::releaseTables() {
+  depths = ShardedStateTable();
+  std::vector<PartialConfiguration>().swap(patterns);
+  std::unordered_map<uint64_t,std::vector<unsigned int> >().swap(pattern_index);
+  std::vector<uint64_t>().swap(frontier);
+  std::vector<uint64_t>().swap(next_frontier);
+  std::vector<std::vector<uint64_t> >().swap(buckets);
+  std::vector<std::vector<uint64_t> >().swap(found);
+}
+
+// A configuration solves the puzzle if the goal robot (or any robot,
+// if no particular robot was requested) sits on the goal
+bool Solver::isSolved(const std::vector<Position> &pos) const {
+  if (goal_robot != -1) return pos[goal_robot] == goal;
+  for (unsigned int i = 0; i < pos.size(); i++) {
+    if (pos[i] == goal) return true;
+  }
+  return false;
+}
+
+// The same for a packed configuration, without unpacking it
+bool Solver::isSolvedKey(const uint64_t *key) const {
+  int goal_cell = (goal.row-1)*board->getCols() + goal.col-1;
+  if (goal_robot != -1) return (int)codec.cell(key,0) == goal_cell;
+  for (int i = 0; i < num_robots; i++) {
+    if ((int)codec.cell(key,i) == goal_cell) return true;
+  }
+  return false;
+}
+
+// Move robot i of a configuration being expanded by the search, using
+// the bitboards when the board is small enough for them
+bool Solver::step(std::vector<Position> &pos, const Occupancy &occ, int i, int direction) const {
+  if (!board->hasBitboards()) return board->moveRobot(pos,i,direction);
+  Position to = board->slideBits(occ,pos[i],direction);
+  if (to == pos[i]) return false;
+  pos[i] = to;
+  return true;
+}
+
+// the seconds since start
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Add a finished layer of a breadth first search to the stats: the
+// configurations it expanded, the ones their moves made and how many of
+// those were new
+void Solver::countLayer(double seconds, long long states, long long generated, long long added) {
+  SolverStats &stats = result->stats;
+  stats.slides += states * num_robots * 4;
+  stats.generated += generated;
+  stats.duplicates += generated - added;
+  stats.peak_frontier = std::max(stats.peak_frontier, states);
+  stats.depth_seconds.push_back(seconds);
+}
+
+// Add a search table to the stats, once the search is done with it
+void Solver::countTable(const ProbeCount &probes, long long size, long long slots) {
+  SolverStats &stats = result->stats;
+  stats.probes.add(probes);
+  stats.table_size += size;
+  stats.table_slots += slots;
+}
+
+
+// ===================
+// BREADTH FIRST SEARCH
+// ===================
+
+// Level-synchronous breadth first search over whole robot
+// configurations.  Configurations are packed into a few bytes (see
+// state.h) and every one is expanded at most once, so the work is
+// proportional to the number of distinct reachable configurations
+// rather than the number of move sequences.  The search stops at the
+// end of the first layer containing a solution, then the optimal move
+// sequences are read back out of the layers by findPaths.  With more than one thread
+// each layer is expanded by expandLayer, which finds exactly the same
+// layers, so the output does not depend on the number of threads.  If
+// the layers outgrow the memory budget, the search starts over with
+// iterative deepening from the first depth that wasn't finished.
+void Solver::solveBFS() {
+  int rows = board->getRows();
+  int cols = board->getCols();
+  int limit = moveLimit();
+  std::vector<Position> start = board->getRobotPositions();
+
+  codec = StateCodec(rows,cols,num_robots,goal_robot);
+  int words = codec.words();
+  std::vector<uint64_t> key(words);
+
+  depths.reset(words, (options.threads == 1) ? 1 : 64);
+  codec.encode(start,&key[0]);
+  depths.shard(depths.shardOf(&key[0])).insert(&key[0],0);
+  if (cache.isOpen() && !isSolved(start)) cache_bound = cachedLength(&key[0],0);
+
+  frontier.assign(key.begin(),key.end());
+  int &mm = result->moves;
+
+  for (int depth = 1; depth <= limit && !frontier.empty(); depth++) {
+    // none of the earlier layers has a solution, so if the cache knows
+    // of one this long it is optimal and this layer isn't needed
+    if (cache_bound == depth) {
+      mm = depth;
+      break;
+    }
+    std::chrono::steady_clock::time_point layer_start = std::chrono::steady_clock::now();
+    next_frontier.clear();
+    result->expanded += frontier.size() / words;
+    long long generated = (options.threads > 1) ? expandLayer(depth) : (this->*expand_serial)(depth);
+    countLayer(secondsSince(layer_start), frontier.size() / words, generated,
+               next_frontier.size() / words);
+    if (out_of_memory) {
+      countTable(depths.probeCount(),0,0);
+      releaseTables();
+      solveIDA(depth);
+      return;
+    }
+    if (mm != -1) break;
+    frontier.swap(next_frontier);
+  }
+  countTable(depths.probeCount(),depths.size(),depths.slots());
+  // the last layer searched still had configurations to expand
+  if (mm == -1 && !frontier.empty()) result->at_limit = true;
+  if (mm == -1) return;
+
+  meet_depth = mm;
+  collectSolutions(start);
+}
+
+// Expand one layer of the search on a single thread, for any board and
+// number of robots.  Returns the number of configurations the moves
+// made (new or not).
+long long Solver::expandLayerSerial(int depth) {
+  int words = codec.words();
+  std::vector<uint64_t> key(words);
+  std::vector<Position> pos;
+  Occupancy occ;
+  StateTable &table = depths.shard(0);
+  int &mm = result->moves;
+  long long generated = 0;
+  for (unsigned int s = 0; s < frontier.size(); s += words) {
+    if ((s/words) % 65536 == 0 && overMemoryLimit()) break;
+    codec.decode(&frontier[s],pos);
+    if (board->hasBitboards()) board->fillOccupancy(pos,occ);
+    for (int i = 0; i < num_robots; i++) {
+      Position from = pos[i];
+      for (int d = NORTH; d <= WEST; d++) {
+        if (!step(pos,occ,i,d)) continue;
+        generated++;
+        codec.encode(pos,&key[0]);
+        if (table.insert(&key[0],depth)) {
+          if (mm == -1 && isSolved(pos)) mm = depth;
+          if (cache.isOpen()) {
+            int length = cachedLength(&key[0],depth);
+            if (length != -1 && (cache_bound == -1 || length < cache_bound)) cache_bound = length;
+          }
+          next_frontier.insert(next_frontier.end(),key.begin(),key.end());
+        }
+        pos[i] = from;
+      }
+    }
+  }
+  return generated;
+}
+
+// Where the robot in slot k of a configuration on a board with COLS
+// columns stops sliding in a direction: the wall stop, pulled back in
+// front of the nearest of the other robots lying on the way there.
+// The robots are checked in a loop of fixed length, which the compiler
+// unrolls.
+template <int COLS, int ROBOTS>
+static inline int slideFixed(const int *cells, int k, int direction, int wall_stop) {
+  int from = cells[k];
+  int to = wall_stop;
+  if (direction == NORTH) {
+    for (int j = 0; j < ROBOTS; j++) {
+      int c = cells[j];
+      if (c % COLS == from % COLS && c < from && c >= to) to = c + COLS;
+    }
+  } else if (direction == SOUTH) {
+    for (int j = 0; j < ROBOTS; j++) {
+      int c = cells[j];
+      if (c % COLS == from % COLS && c > from && c <= to) to = c - COLS;
+    }
+  } else if (direction == EAST) {
+    for (int j = 0; j < ROBOTS; j++) {
+      int c = cells[j];
+      if (c / COLS == from / COLS && c > from && c <= to) to = c - 1;
+    }
+  } else {
+    for (int j = 0; j < ROBOTS; j++) {
+      int c = cells[j];
+      if (c / COLS == from / COLS && c < from && c >= to) to = c + 1;
+    }
+  }
+  return to;
+}
+
+// The moves from frontier states first to last-1 on a board of ROWS x
+// COLS cells with ROBOTS robots, each passed to emit as a packed key
+// (made by moving robot slot k) along with the cells of the new
+// configuration.  Every configuration is a single word with one byte
+// per robot (see StateCodec), which is unpacked into a fixed size array
+// of cells, moved with slideFixed and packed again by moving the one
+// robot that changed to its place among the sorted interchangeable
+// robots (from slot first on).  Nothing is allocated and every loop
+// over the robots has a fixed length.  Returns the number of moves made.
+template <int ROWS, int COLS, int ROBOTS, class Emit>
+static inline long long movesFixed(const uint64_t *states, unsigned int first, unsigned int last,
+                                   const unsigned char (*stops)[4], int first_slot, Emit emit) {
+  long long generated = 0;
+  for (unsigned int s = first; s < last; s++) {
+    int cells[ROBOTS];
+    for (int k = 0; k < ROBOTS; k++) cells[k] = (states[s] >> (8*k)) & 0xff;
+    for (int k = 0; k < ROBOTS; k++) {
+      for (int d = NORTH; d <= WEST; d++) {
+        int to = slideFixed<COLS,ROBOTS>(cells,k,d,stops[cells[k]][d]);
+        if (to == cells[k]) continue;
+        generated++;
+        int next[ROBOTS];
+        for (int j = 0; j < ROBOTS; j++) next[j] = cells[j];
+        int m = k;
+        if (k >= first_slot) {
+          while (m > first_slot && next[m-1] > to) { next[m] = next[m-1]; m--; }
+          while (m+1 < ROBOTS && next[m+1] < to) { next[m] = next[m+1]; m++; }
+        }
+        next[m] = to;
+        uint64_t key = 0;
+        for (int j = 0; j < ROBOTS; j++) key |= uint64_t(next[j]) << (8*j);
+        emit(key,next);
+      }
+    }
+  }
+  return generated;
+}
+
+// The slide stops of a board of CELLS cells as bytes, for movesFixed
+template <int CELLS>
+static inline void fixedStops(const Board &board, unsigned char (*stops)[4]) {
+  for (int c = 0; c < CELLS; c++) {
+    for (int d = NORTH; d <= WEST; d++) stops[c][d] = board.slideStop(c,d);
+  }
+}
+
+// expandLayerSerial specialized at compile time for boards of ROWS x
+// COLS cells with ROBOTS robots, using movesFixed.  The layer comes out
+// in a different order than from expandLayerSerial, but with the same
+// configurations.
+template <int ROWS, int COLS, int ROBOTS>
+long long Solver::expandLayerFixed(int depth) {
+  static const int CELLS = ROWS*COLS;
+  static_assert(CELLS <= 256 && ROBOTS <= 8, "a configuration must fit in one word");
+  assert (board->getRows() == ROWS && board->getCols() == COLS && num_robots == ROBOTS);
+  assert (codec.words() == 1);
+
+  unsigned char stops[CELLS][4];
+  fixedStops<CELLS>(*board,stops);
+  // the goal robot (if any) keeps the first slot, the others are sorted
+  int first = (goal_robot == -1) ? 0 : 1;
+  int goal_cell = (goal.row-1)*COLS + goal.col-1;
+  StateTable &table = depths.shard(0);
+  int &mm = result->moves;
+  long long generated = 0;
+
+  for (unsigned int begin = 0; begin < frontier.size(); begin += 65536) {
+    if (overMemoryLimit()) break;
+    unsigned int end = std::min((unsigned int)frontier.size(), begin + 65536);
+    generated += movesFixed<ROWS,COLS,ROBOTS>(&frontier[0],begin,end,stops,first,
+                                              [&](uint64_t key, const int *next) {
+      if (!table.insert(&key,depth)) return;
+      if (mm == -1) {
+        // the goal robot is in slot 0, otherwise any robot will do
+        bool solved = (next[0] == goal_cell);
+        for (int j = 1; j < ROBOTS && goal_robot == -1; j++) {
+          if (next[j] == goal_cell) solved = true;
+        }
+        if (solved) mm = depth;
+      }
+      if (cache.isOpen()) {
+        int length = cachedLength(&key,depth);
+        if (length != -1 && (cache_bound == -1 || length < cache_bound)) cache_bound = length;
+      }
+      next_frontier.push_back(key);
+    });
+  }
+  return generated;
+}
+
+// The first phase of expandLayer for one piece of a block, frontier
+// states first to last-1, for any board and number of robots: every
+// configuration the moves make goes into the piece's buckets, by shard
+// (the thread that owns the shard drops the ones seen before).  Returns
+// the number of moves made.
+long long Solver::expandPieceSerial(unsigned int first, unsigned int last, int piece) {
+  int words = codec.words();
+  int shards = depths.numShards();
+  std::vector<Position> pos;
+  std::vector<uint64_t> key(words);
+  Occupancy occ;
+  long long generated = 0;
+  for (unsigned int s = first; s < last; s++) {
+    codec.decode(&frontier[s*words],pos);
+    if (board->hasBitboards()) board->fillOccupancy(pos,occ);
+    for (int i = 0; i < num_robots; i++) {
+      Position from = pos[i];
+      for (int d = NORTH; d <= WEST; d++) {
+        if (!step(pos,occ,i,d)) continue;
+        generated++;
+        codec.encode(pos,&key[0]);
+        std::vector<uint64_t> &bucket = buckets[piece*shards + depths.shardOf(&key[0])];
+        bucket.insert(bucket.end(),key.begin(),key.end());
+        pos[i] = from;
+      }
+    }
+  }
+  return generated;
+}
+
+// expandPieceSerial specialized at compile time like expandLayerFixed
+template <int ROWS, int COLS, int ROBOTS>
+long long Solver::expandPieceFixed(unsigned int first, unsigned int last, int piece) {
+  static const int CELLS = ROWS*COLS;
+  assert (codec.words() == 1);
+  unsigned char stops[CELLS][4];
+  fixedStops<CELLS>(*board,stops);
+  std::vector<uint64_t> *piece_buckets = &buckets[piece*depths.numShards()];
+  return movesFixed<ROWS,COLS,ROBOTS>(&frontier[0],first,last,stops,(goal_robot == -1) ? 0 : 1,
+                                      [&](uint64_t key, const int *) {
+    piece_buckets[depths.shardOf(&key)].push_back(key);
+  });
+}
+
+// Pick the layer expansions for the board of the current solve: one of
+// the specialized versions for the common board sizes and numbers of
+// robots, or the generic one
+void Solver::chooseLayerExpansion() {
+  int rows = board->getRows();
+  int cols = board->getCols();
+  expand_serial = &Solver::expandLayerSerial;
+  expand_piece = &Solver::expandPieceSerial;
+  if (rows == 8 && cols == 8 && num_robots == 4) {
+    expand_serial = &Solver::expandLayerFixed<8,8,4>;
+    expand_piece = &Solver::expandPieceFixed<8,8,4>;
+  } else if (rows == 16 && cols == 16 && num_robots == 4) {
+    expand_serial = &Solver::expandLayerFixed<16,16,4>;
+    expand_piece = &Solver::expandPieceFixed<16,16,4>;
+  } else if (rows == 16 && cols == 16 && num_robots == 5) {
+    expand_serial = &Solver::expandLayerFixed<16,16,5>;
+    expand_piece = &Solver::expandPieceFixed<16,16,5>;
+  }
+}
+
+// Expand one layer of the search with several threads.  The frontier
+// is handled in blocks, each in two phases: first the block is cut into
+// pieces, and the moves from each piece are generated and sorted into
+// the piece's buckets by shard; then each shard inserts the buckets
+// meant for it, in piece order, which drops the configurations seen
+// before, so each one is looked up just once.  No two threads ever write to
+// the same shard, so no locking is needed, and the new layer comes out
+// the same regardless of how the threads are scheduled.  The phases run
+// on the threads of pool, which are started once and kept from one
+// solve to the next, and the buckets keep their memory from one block
+// to the next.  Returns the number of configurations the moves made
+// (new or not).
+long long Solver::expandLayer(int depth) {
+  const unsigned int block_states = 1 << 16;
+  int threads = options.threads;
+  // a few pieces per thread, so that a thread that finishes early can
+  // steal some of the work of the others
+  int pieces = 4*threads;
+  int words = codec.words();
+  int shards = depths.numShards();
+  unsigned int num_states = frontier.size() / words;
+  if (!pool || pool->numWorkers() != threads) pool.reset(new WorkStealingPool(threads));
+
+  // buckets[p*shards + s] holds the configurations piece p found for
+  // shard s, and found[s] the new configurations of shard s
+  buckets.resize(pieces*shards);
+  found.resize(shards);
+  for (int s = 0; s < shards; s++) found[s].clear();
+  // whether any of the new configurations of each shard solve the
+  // puzzle, and the shortest solution through a cached configuration in
+  // each shard
+  std::vector<char> solved(shards,0);
+  std::vector<int> cached(shards,-1);
+  // the configurations each thread made, for the stats
+  std::vector<long long> generated(threads,0);
+
+  for (unsigned int begin = 0; begin < num_states; begin += block_states) {
+    if (overMemoryLimit()) break;
+    unsigned int end = std::min(num_states, begin + block_states);
+
+    // phase 1: generate the moves from this block
+    pool->run(pieces, [&](int t, int p) {
+      unsigned int first = begin + (unsigned long long)(end-begin)*p/pieces;
+      unsigned int last = begin + (unsigned long long)(end-begin)*(p+1)/pieces;
+      generated[t] += (this->*expand_piece)(first,last,p);
+    });
+
+    // phase 2: insert the new configurations, each shard by one thread
+    pool->run(shards, [&](int, int s) {
+      StateTable &table = depths.shard(s);
+      for (int p = 0; p < pieces; p++) {
+        std::vector<uint64_t> &bucket = buckets[p*shards + s];
+        for (unsigned int k = 0; k < bucket.size(); k += words) {
+          if (!table.insert(&bucket[k],depth)) continue;
+          found[s].insert(found[s].end(),bucket.begin()+k,bucket.begin()+k+words);
+          if (!solved[s]) solved[s] = isSolvedKey(&bucket[k]);
+          if (cache.isOpen()) {
+            int length = cachedLength(&bucket[k],depth);
+            if (length != -1 && (cached[s] == -1 || length < cached[s])) cached[s] = length;
+          }
+        }
+        bucket.clear();
+      }
+    });
+  }
+
+  // merge the results in a fixed order (unless the layer wasn't
+  // finished)
+  for (int s = 0; s < shards && !out_of_memory; s++) {
+    next_frontier.insert(next_frontier.end(),found[s].begin(),found[s].end());
+    if (solved[s] && result->moves == -1) result->moves = depth;
+    if (cached[s] != -1 && (cache_bound == -1 || cached[s] < cache_bound)) cache_bound = cached[s];
+  }
+  long long total = 0;
+  for (int t = 0; t < threads; t++) total += generated[t];
+  return total;
+}
+
+// Read the optimal solutions back out of the layers of a finished
+// search.  The moves that go from one layer to the next on the way to a
+// solution form a DAG, which is walked depth first in robot/direction
+// order, so the first solution found is the lexicographically smallest
+// (the one printed in the default mode) and the others follow in
+// order.  When all of them are wanted they are counted first, by
+// dynamic programming over the same DAG, so the total is known before
+// the first one is passed on.
+void Solver::collectSolutions(const std::vector<Position> &start) {
+  int words = codec.words();
+  // the goal distances cut off the moves that can't reach the goal in
+  // time before their configurations are even looked up
+  prepareGoalDistances();
+  path_keys.resize((result->moves+1)*words);
+  std::vector<Position> pos = start;
+  if (options.all_solutions || options.count_solutions) {
+    counts.reset(words);
+    result->solutions = countPaths(pos,0);
+  } else {
+    result->solutions = 1;
+  }
+  dead.reset(words);
+  streaming = true;
+  MovePath path;
+  findPaths(pos,0,path);
+  streaming = false;
+}
+
+// Whether a move from the layer at depth to next stays on the way to
+// an optimal solution: the last move must solve the puzzle, and every
+// other one must leave few enough moves for the goal distance and reach
+// the next layer (before meet_depth) or a configuration the right
+// number of moves from a solution (after it, found by the backward
+// search).  Leaves next packed in key, unless it was cut off before.
+bool Solver::onPath(const std::vector<Position> &next, int depth, uint64_t *key) const {
+  int mm = result->moves;
+  if (depth+1 == mm) return isSolved(next);
+  if (depth+1 + goalDistance(next) > mm) return false;
+  codec.encode(next,key);
+  if (depth+1 < meet_depth) return depths.find(key) == depth+1;
+  return backwardDistance(key) == mm-depth-1;
+}
+
+// Depth first walk of the DAG of optimal moves, moving the robots of
+// pos in place (it is back as it was on return).  Configurations that
+// turn out not to lead to a solution are remembered in dead, so each
+// one is explored at most once.  Returns true if at least one solution
+// was recorded.
+bool Solver::findPaths(std::vector<Position> &pos, int depth, MovePath &path) {
+  int mm = result->moves;
+  bool found = false;
+  uint64_t *key = &path_keys[(depth+1)*codec.words()];
+  Occupancy occ;
+  if (board->hasBitboards()) board->fillOccupancy(pos,occ);
+  for (int i = 0; i < num_robots; i++) {
+    Position from = pos[i];
+    for (int d = NORTH; d <= WEST; d++) {
+      if (!step(pos,occ,i,d)) continue;
+      if (onPath(pos,depth,key) && (depth+1 == mm || dead.find(key) == -1)) {
+        path.push_back(makeMove(i,d));
+        bool ok = true;
+        if (depth+1 == mm) {
+          recordSolution(path);
+        } else {
+          ok = findPaths(pos,depth+1,path);
+        }
+        path.pop_back();
+        if (ok) {
+          found = true;
+        } else {
+          dead.insert(key,0);
+        }
+      }
+      pos[i] = from;
+      if (found && !options.all_solutions) return true;
+    }
+  }
+  return found;
+}
+
+// The number of optimal solutions that continue from a configuration
+// in the layer at depth, each configuration counted once and the
+// counts remembered in counts (pos is moved in place like in findPaths)
+uint64_t Solver::countPaths(std::vector<Position> &pos, int depth) {
+  int mm = result->moves;
+  uint64_t total = 0;
+  uint64_t *key = &path_keys[(depth+1)*codec.words()];
+  Occupancy occ;
+  if (board->hasBitboards()) board->fillOccupancy(pos,occ);
+  for (int i = 0; i < num_robots; i++) {
+    Position from = pos[i];
+    for (int d = NORTH; d <= WEST; d++) {
+      if (!step(pos,occ,i,d)) continue;
+      if (onPath(pos,depth,key)) {
+        if (depth+1 == mm) {
+          total++;
+        } else {
+          uint64_t n;
+          if (!counts.find(key,n)) {
+            n = countPaths(pos,depth+1);
+            counts.insert(key,n);
+          }
+          total += n;
+        }
+      }
+      pos[i] = from;
+    }
+  }
+  return total;
+}
+
+// Keep a solution, or pass it on if that was asked for.  Only the
+// first one is kept unless all of them were requested, and nothing is
+// passed on unless streaming is set.  The first one also goes in the
+// cache.
+void Solver::recordSolution(const MovePath &path) {
+  if (cache.isOpen() && !cache_stored) {
+    // remember how far each configuration along the first solution is
+    // from the goal, for later runs (solved ones are left out: the
+    // start may be on the goal, and others never are)
+    cache_stored = true;
+    std::vector<Position> pos = board->getRobotPositions();
+    std::vector<uint64_t> key(codec.words());
+    for (unsigned int j = 0; j < path.size(); j++) {
+      if (!isSolved(pos)) {
+        codec.encode(pos,&key[0]);
+        cache.store(&key[0],path.size()-j);
+      }
+      board->moveRobot(pos,moveRobotId(path[j]),moveDirection(path[j]));
+    }
+  }
+  if (options.all_solutions && options.on_solution) {
+    if (streaming) options.on_solution(path,result->solutions);
+  } else if (options.all_solutions || result->paths.empty()) {
+    result->paths.push_back(path);
+  }
+}
+
+
+// The length of the solution through a configuration at depth, if the
+// cache has it (or -1)
+int Solver::cachedLength(const uint64_t *key, int depth) const {
+  int distance = cache.find(key);
+  return (distance == -1) ? -1 : depth + distance;
+}
+
+
+// ===================
+// BIDIRECTIONAL SEARCH
+// ===================
+
+// The most robots other than the goal robot a partial configuration
+// can place (their cells are packed into one word with the goal
+// robot's, see packPlaced).
+static const int MAX_PLACED = 6;
+
+// The cell sets of partial configurations, one bit per cell of a board
+// of up to 16x16 cells
+static inline bool hasCell(const uint64_t *cells, int cell) {
+  return (cells[cell >> 6] >> (cell & 63)) & 1;
+}
+static inline void addCell(uint64_t *cells, int cell) {
+  cells[cell >> 6] |= uint64_t(1) << (cell & 63);
+}
+static inline void removeCell(uint64_t *cells, int cell) {
+  cells[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+}
+
+// The placed robots of a partial configuration in one word: the goal
+// robot's cell in the low byte, the cells of the others (in increasing
+// order) in the bytes above it and their number in the top byte
+static uint64_t packPlaced(int goal_cell, const int *others, int n) {
+  uint64_t placed = uint64_t(goal_cell) | (uint64_t(n) << 56);
+  for (int k = 0; k < n; k++) placed |= uint64_t(others[k]) << (8 + 8*k);
+  return placed;
+}
+
+// the reverse of packPlaced, returns the number of other robots
+static int unpackPlaced(uint64_t placed, int &goal_cell, int *others) {
+  int n = placed >> 56;
+  goal_cell = placed & 255;
+  for (int k = 0; k < n; k++) others[k] = (placed >> (8 + 8*k)) & 255;
+  return n;
+}
+
+// Breadth first search from the start and, at the same time, backwards
+// from the goal, always growing whichever side has the smaller frontier
+// by one whole layer, until a configuration on the forward frontier is
+// known to be the right number of moves from a solution.  Starting the
+// backward half from every configuration with the goal robot on the
+// goal would mean every placement of the other robots, far more than
+// the forward search ever reaches on a 16x16 board with 4 or 5 robots.
+// Instead it works on partial configurations, which only place the
+// robots the last moves depend on (see PartialConfiguration): it starts
+// from the single one with just the goal robot on the goal, and each
+// layer adds the partial configurations one move before those of the
+// last layer.  The fewest moves from any configuration to a solution,
+// up to the depth the backward half has reached, is the shallowest
+// partial configuration it fits, so findPaths reads off exactly the
+// same solutions as solveBFS: the forward layers up to the meeting
+// point, and these distances after it.  Only boards of up to 16x16
+// cells with at most MAX_PLACED robots besides the goal robot are
+// searched this way; on others the plain breadth first search is used.
+void Solver::solveBidirectional() {
+  int rows = board->getRows();
+  int cols = board->getCols();
+  int limit = moveLimit();
+  std::vector<Position> start = board->getRobotPositions();
+  assert (goal_robot != -1 && start[goal_robot] != goal);
+  if (!board->hasBitboards() || num_robots-1 > MAX_PLACED) {
+    solveBFS();
+    return;
+  }
+
+  codec = StateCodec(rows,cols,num_robots,goal_robot);
+  int words = codec.words();
+  std::vector<uint64_t> key(words);
+  depths.reset(words,1);
+  codec.encode(start,&key[0]);
+  depths.shard(0).insert(&key[0],0);
+  frontier.assign(key.begin(),key.end());
+
+  patterns.clear();
+  pattern_index.clear();
+  PartialConfiguration solved;
+  solved.placed = packPlaced((goal.row-1)*cols + goal.col-1,NULL,0);
+  for (int w = 0; w < 4; w++) solved.free[w] = 0;
+  solved.depth = 0;
+  addPattern(solved);
+  // the first partial configuration of the last backward layer
+  unsigned int layer = 0;
+
+  int forward_depth = 0;
+  int backward_depth = 0;
+  int meeting = -1;
+  while (meeting == -1 && forward_depth + backward_depth < limit && !frontier.empty() &&
+         !out_of_memory) {
+    long long forward_size = frontier.size() / words;
+    long long backward_size = patterns.size() - layer;
+    // once the backward half has run out of partial configurations it
+    // knows every configuration that can reach the goal at all
+    if (forward_size <= backward_size || backward_size == 0) {
+      expandForward(++forward_depth);
+    } else {
+      unsigned int next = patterns.size();
+      expandBackward(++backward_depth,layer);
+      layer = next;
+    }
+    meeting = meetingDistance();
+  }
+  countTable(depths.probeCount(),depths.size(),depths.slots());
+  if (out_of_memory) {
+    // every solution uses more moves than the finished layers cover
+    releaseTables();
+    solveIDA(forward_depth + backward_depth);
+    return;
+  }
+  if (meeting == -1) {
+    result->at_limit = (forward_depth + backward_depth >= limit && !frontier.empty());
+    return;
+  }
+
+  result->moves = forward_depth + meeting;
+  meet_depth = forward_depth;
+  collectSolutions(start);
+}
+
+// Add a partial configuration to the backward search, unless one found
+// as early already covers every configuration it does (one with the
+// goal robot in the same cell, some of its other robots and some of
+// its free cells).  Returns whether it was added.
+bool Solver::addPattern(const PartialConfiguration &pattern) {
+  int goal_cell;
+  int others[MAX_PLACED];
+  int n = unpackPlaced(pattern.placed,goal_cell,others);
+  int subset[MAX_PLACED];
+  for (int mask = 0; mask < (1 << n); mask++) {
+    int m = 0;
+    for (int k = 0; k < n; k++) {
+      if (mask & (1 << k)) subset[m++] = others[k];
+    }
+    std::unordered_map<uint64_t,std::vector<unsigned int> >::const_iterator found =
+      pattern_index.find(packPlaced(goal_cell,subset,m));
+    if (found == pattern_index.end()) continue;
+    for (unsigned int i = 0; i < found->second.size(); i++) {
+      const uint64_t *free = patterns[found->second[i]].free;
+      if (!((free[0] & ~pattern.free[0]) | (free[1] & ~pattern.free[1]) |
+            (free[2] & ~pattern.free[2]) | (free[3] & ~pattern.free[3]))) return false;
+    }
+  }
+  pattern_index[pattern.placed].push_back(patterns.size());
+  patterns.push_back(pattern);
+  return true;
+}
+
+// The fewest moves from a configuration to a solution, if the backward
+// search has got that far (-1 if it hasn't): the depth of the
+// shallowest partial configuration it fits, found by looking up its
+// goal robot's cell with every subset of the cells of the others.
+int Solver::backwardDistance(const uint64_t *key) const {
+  int others = num_robots - 1;
+  int goal_cell = codec.cell(key,0);
+  int cells[MAX_PLACED];
+  uint64_t occupied[4] = { 0, 0, 0, 0 };
+  addCell(occupied,goal_cell);
+  for (int k = 0; k < others; k++) {
+    cells[k] = codec.cell(key,k+1);
+    addCell(occupied,cells[k]);
+  }
+  int best = -1;
+  int subset[MAX_PLACED];
+  for (int mask = 0; mask < (1 << others); mask++) {
+    int m = 0;
+    for (int k = 0; k < others; k++) {
+      if (mask & (1 << k)) subset[m++] = cells[k];
+    }
+    std::unordered_map<uint64_t,std::vector<unsigned int> >::const_iterator found =
+      pattern_index.find(packPlaced(goal_cell,subset,m));
+    if (found == pattern_index.end()) continue;
+    for (unsigned int i = 0; i < found->second.size(); i++) {
+      const PartialConfiguration &pattern = patterns[found->second[i]];
+      if ((pattern.free[0] & occupied[0]) | (pattern.free[1] & occupied[1]) |
+          (pattern.free[2] & occupied[2]) | (pattern.free[3] & occupied[3])) continue;
+      if (best == -1 || pattern.depth < best) best = pattern.depth;
+    }
+  }
+  return best;
+}
+
+// The fewest moves from a configuration on the forward frontier to a
+// solution, as far as the backward search knows (-1 if it knows of none)
+int Solver::meetingDistance() const {
+  int words = codec.words();
+  int best = -1;
+  for (unsigned int s = 0; s < frontier.size(); s += words) {
+    int distance = backwardDistance(&frontier[s]);
+    if (distance != -1 && (best == -1 || distance < best)) best = distance;
+  }
+  return best;
+}
+
+// Grow the forward search by one layer, with the same single threaded
+// expansion as solveBFS
+void Solver::expandForward(int depth) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int words = codec.words();
+  next_frontier.clear();
+  result->expanded += frontier.size() / words;
+  long long generated = (this->*expand_serial)(depth);
+  // the meeting point, not the expansion, decides the number of moves
+  result->moves = -1;
+  countLayer(secondsSince(start), frontier.size() / words, generated, next_frontier.size() / words);
+  frontier.swap(next_frontier);
+}
+
+// Grow the backward search by one layer, from the partial
+// configurations first to the end of patterns.  Each one is taken back
+// over every move that could have made part of it true: the goal robot
+// or one of the other robots it places sliding into its cell, or a
+// robot it doesn't place sliding out of one of its free cells.  The
+// moving robot came from (or goes through) cells that were free, and
+// it stopped at a wall or a robot, which may have to be placed too.
+void Solver::expandBackward(int depth, unsigned int first) {
+  static const int dr[4] = { -1, 1, 0, 0 };
+  static const int dc[4] = { 0, 0, 1, -1 };
+  static const int reverse[4] = { SOUTH, NORTH, WEST, EAST };
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int cols = board->getCols();
+  int cells = board->getRows() * cols;
+  int capacity = num_robots - 1;
+  unsigned int last = patterns.size();
+  long long generated = 0;
+  result->expanded += last - first;
+  for (unsigned int p = first; p < last; p++) {
+    if ((p-first) % 65536 == 0 && overMemoryLimit()) break;
+    // patterns grows while this one is taken back
+    PartialConfiguration pattern = patterns[p];
+    int goal_cell;
+    int others[MAX_PLACED];
+    int n = unpackPlaced(pattern.placed,goal_cell,others);
+    uint64_t occupied[4] = { 0, 0, 0, 0 };
+    addCell(occupied,goal_cell);
+    for (int k = 0; k < n; k++) addCell(occupied,others[k]);
+
+    // robot -1 is the goal robot, 0 to n-1 the other placed robots, and
+    // n a robot the pattern doesn't place, leaving a free cell
+    for (int robot = -1; robot <= n; robot++) {
+      if (robot == n && n == capacity) break;
+      for (int d = NORTH; d <= WEST; d++) {
+        int step = dr[d]*cols + dc[d];
+        // the pairs of cells the robot could have slid between
+        std::vector<std::pair<int,int> > slides;
+        if (robot < n) {
+          int to = (robot == -1) ? goal_cell : others[robot];
+          int stop = board->slideStop(to,reverse[d]);
+          for (int from = to; from != stop; ) {
+            from -= step;
+            if (hasCell(occupied,from)) break;
+            slides.push_back(std::make_pair(from,to));
+          }
+        } else {
+          for (int from = 0; from < cells; from++) {
+            if (!hasCell(pattern.free,from)) continue;
+            int stop = board->slideStop(from,d);
+            for (int to = from; to != stop; ) {
+              to += step;
+              if (hasCell(occupied,to)) break;
+              // it would end up on a cell that has to be free
+              if (!hasCell(pattern.free,to)) slides.push_back(std::make_pair(from,to));
+            }
+          }
+        }
+
+        for (unsigned int k = 0; k < slides.size(); k++) {
+          int from = slides[k].first;
+          int to = slides[k].second;
+          // what stopped the robot: a wall, a placed robot, or else a
+          // robot that has to be placed
+          int stopper = -1;
+          if (board->slideStop(to,d) != to && !hasCell(occupied,to+step)) {
+            if (hasCell(pattern.free,to+step)) continue;
+            stopper = to+step;
+          }
+          int placed[MAX_PLACED+1];
+          int m = 0;
+          for (int j = 0; j < n; j++) placed[m++] = (j == robot) ? from : others[j];
+          if (robot == n) placed[m++] = from;
+          if (stopper != -1) placed[m++] = stopper;
+          if (m > capacity) continue;
+          std::sort(placed,placed+m);
+          generated++;
+
+          PartialConfiguration before;
+          before.placed = packPlaced((robot == -1) ? from : goal_cell,placed,m);
+          for (int w = 0; w < 4; w++) before.free[w] = pattern.free[w];
+          removeCell(before.free,from);
+          for (int cell = from; cell != to; ) {
+            cell += step;
+            addCell(before.free,cell);
+          }
+          before.depth = depth;
+          addPattern(before);
+        }
+      }
+    }
+  }
+  countLayer(secondsSince(start), last - first, generated, patterns.size() - last);
+}
+
+
+// ===================
+// ITERATIVE DEEPENING A*
+// ===================
+
+// The fewest number of moves a robot needs to get from each cell to the
+// goal, found with a breadth first search backwards from the goal.
+// Other robots are ignored, but because a robot can stop in front of
+// another robot, a move may end anywhere before the next wall, not only
+// at the wall.  That keeps the count a lower bound on the real number
+// of moves (an admissible heuristic for solveIDA).
+void computeGoalDistances(const Board &board, std::vector<int> &distances) {
+  static const int dr[4] = { -1, 1, 0, 0 };
+  static const int dc[4] = { 0, 0, 1, -1 };
+  int cols = board.getCols();
+  distances.assign(board.getRows()*cols,-1);
+  std::vector<int> queue;
+  Position goal = board.getGoal();
+  int goal_cell = (goal.row-1)*cols + goal.col-1;
+  distances[goal_cell] = 0;
+  queue.push_back(goal_cell);
+  for (unsigned int q = 0; q < queue.size(); q++) {
+    int cell = queue[q];
+    // every cell between this one and the next wall can get here in
+    // one move, by sliding back the other way and being stopped here
+    for (int d = NORTH; d <= WEST; d++) {
+      int stop = board.slideStop(cell,d);
+      int r = cell / cols;
+      int c = cell % cols;
+      while (r*cols + c != stop) {
+        r += dr[d];
+        c += dc[d];
+        int &v = distances[r*cols + c];
+        if (v == -1) {
+          v = distances[cell] + 1;
+          queue.push_back(r*cols + c);
+        }
+      }
+    }
+  }
+}
+
+// Point goal_distances at the goal distances of the current board: the
+// ones passed in the options, or else computed here
+void Solver::prepareGoalDistances() {
+  if (options.goal_distances) {
+    assert ((int)options.goal_distances->size() == board->getRows()*board->getCols());
+    goal_distances = &(*options.goal_distances)[0];
+  } else {
+    computeGoalDistances(*board,own_goal_distances);
+    goal_distances = &own_goal_distances[0];
+  }
+}
+
+// The heuristic for a configuration: the goal distance of the goal
+// robot, or of the closest robot if any robot may reach the goal
+// (a large number if no robot can ever get there)
+int Solver::goalDistance(const std::vector<Position> &pos) const {
+  int cols = board->getCols();
+  int best = -1;
+  for (unsigned int i = 0; i < pos.size(); i++) {
+    if (goal_robot != -1 && (int)i != goal_robot) continue;
+    int v = goal_distances[(pos[i].row-1)*cols + pos[i].col-1];
+    if (v != -1 && (best == -1 || v < best)) best = v;
+  }
+  return (best == -1) ? board->getRows()*cols : best;
+}
+
+// The lower bound on the moves left that solveIDA uses: the goal
+// distance, raised by the pattern database for each helper, or the
+// exact number of moves if the cache has it (key is scratch space for
+// packing the configuration)
+int Solver::estimateMoves(const std::vector<Position> &pos, uint64_t *key) const {
+  int estimate = goalDistance(pos);
+  if (pdb.isOpen()) {
+    int cols = board->getCols();
+    int goal_cell = (pos[goal_robot].row-1)*cols + pos[goal_robot].col-1;
+    for (int i = 0; i < num_robots; i++) {
+      if (i == goal_robot) continue;
+      int v = pdb.distance(goal_cell, (pos[i].row-1)*cols + pos[i].col-1);
+      if (v == PatternDatabase::UNREACHABLE) v = board->getRows()*cols;
+      if (v > estimate) estimate = v;
+    }
+  }
+  if (cache.isOpen() && !isSolved(pos)) {
+    codec.encode(pos,key);
+    int distance = cache.find(key);
+    if (distance > estimate) estimate = distance;
+  }
+  return estimate;
+}
+
+// Iterative deepening A*: repeated depth first searches, each one
+// abandoning a sequence of moves as soon as the moves made so far plus
+// the goal distance exceed the current bound, which is then raised to
+// the smallest value that was cut off.  The goal distance never
+// increases by more than one per move, so every solution found in an
+// iteration uses exactly the bound number of moves, and the first one
+// found is the same lexicographically smallest solution the breadth
+// first search reports.  Besides the current move sequence, only a
+// transposition table of bounded size is stored, so that
+// configurations reached again (by a different order of the same
+// moves, say) are not searched from twice in one iteration.  The
+// iterations start at first_bound if that is known to be no more than
+// the length of the solution.
+void Solver::solveIDA(int first_bound) {
+  int limit = moveLimit();
+  prepareGoalDistances();
+  // the pattern database only covers puzzles with a goal robot
+  if (!options.pdb_file.empty() && goal_robot != -1) {
+    result->pdb_used = pdb.open(options.pdb_file,*board);
+  }
+
+  codec = StateCodec(board->getRows(),board->getCols(),num_robots,goal_robot);
+  int words = codec.words();
+  // allow for the empty slots and for the table doubling in size
+  long long cap = options.mem_limit / (5 * (words*sizeof(uint64_t) + sizeof(unsigned short)));
+  transposition_cap = std::min(cap, 1LL << 30);
+
+  std::vector<Position> pos = board->getRobotPositions();
+  MovePath path;
+  if (ida_keys.size() < (size_t)words) ida_keys.resize(words);
+  int bound = std::max(estimateMoves(pos,&ida_keys[0]),first_bound);
+  if (bound == 0) bound = 1;
+  SolverStats &stats = result->stats;
+  while (bound <= limit) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    // a key for each depth the iteration can reach
+    if (ida_keys.size() < (size_t)(bound+1)*words) ida_keys.resize((bound+1)*words);
+    transpositions.reset(words);
+    ida_found = 0;
+    int next = idaSearch(pos,0,bound,-1,-1,path);
+    bool solved = ida_found > 0;
+    if (solved) {
+      result->moves = bound;
+      result->solutions = ida_found;
+      if (options.all_solutions && options.on_solution) {
+        // now that they have been counted, find them all again to pass
+        // them on
+        stats.probes.add(transpositions.probeCount());
+        transpositions.reset(words);
+        ida_found = 0;
+        streaming = true;
+        idaSearch(pos,0,bound,-1,-1,path);
+        streaming = false;
+      }
+    }
+    stats.depth_seconds.push_back(secondsSince(start));
+    stats.probes.add(transpositions.probeCount());
+    // only the table of the last iteration is left at the end
+    stats.table_size = transpositions.size();
+    stats.table_slots = transpositions.slots();
+    if (solved) return;
+    // nothing was cut off, so no solution exists at any depth
+    if (next == -1) return;
+    bound = next;
+  }
+  // (an estimate of rows*cols or more only comes from a robot that can
+  // never reach the goal)
+  result->at_limit = (bound < board->getRows()*board->getCols());
+}
+
+// One depth first pass of solveIDA.  Returns the smallest estimate that
+// exceeded the bound (-1 if none did).  Moving the robot that was just
+// moved back the way it came is skipped: it either undoes the move or
+// ends somewhere the previous configuration could reach in one move,
+// so it is never part of an optimal solution.  A configuration already
+// searched from after fewer moves is skipped, and so is one already
+// searched from after as many moves unless every solution is wanted
+// (or counted) and some were found from there (they have to be found
+// again with this move sequence in front).
+int Solver::idaSearch(std::vector<Position> &pos, int moves, int bound,
+                      int last_robot, int last_direction, MovePath &path) {
+  static const int reverse[4] = { SOUTH, NORTH, WEST, EAST };
+  int words = codec.words();
+  uint64_t *key = &ida_keys[moves*words];
+  codec.encode(pos,key);
+  int seen = transpositions.find(key,result->stats.probes);
+  if (seen != -1 && (seen/2 < moves || seen == 2*moves)) {
+    result->stats.duplicates++;
+    return -1;
+  }
+  bool recorded = (seen != -1 || transpositions.size() < transposition_cap);
+  if (recorded) transpositions.set(key, (seen == 2*moves+1) ? seen : 2*moves);
+  unsigned long long solutions = ida_found;
+  bool find_all = options.all_solutions || options.count_solutions;
+
+  result->expanded++;
+  int next = -1;
+  for (int i = 0; i < num_robots; i++) {
+    for (int d = NORTH; d <= WEST; d++) {
+      if (i == last_robot && reverse[d] == last_direction) continue;
+      Position from = pos[i];
+      result->stats.slides++;
+      if (!board->moveRobot(pos,i,d)) continue;
+      result->stats.generated++;
+      path.push_back(makeMove(i,d));
+      if (isSolved(pos)) {
+        ida_found++;
+        recordSolution(path);
+      } else {
+        int estimate = moves + 1 + estimateMoves(pos,&ida_keys[(moves+1)*words]);
+        if (estimate > bound) {
+          if (next == -1 || estimate < next) next = estimate;
+        } else {
+          int n = idaSearch(pos,moves+1,bound,i,d,path);
+          if (n != -1 && (next == -1 || n < next)) next = n;
+        }
+      }
+      path.pop_back();
+      pos[i] = from;
+      if (!find_all && ida_found > 0) return next;
+    }
+  }
+  if (recorded && ida_found > solutions) transpositions.set(key, 2*moves+1);
+  return next;
+}
+
+
+// ===================
+// ACCESSIBILITY
+// ===================
+
+// Mark every cell a robot starting from cell could ever get to, if
+// other robots could be anywhere to stop it: anywhere between a cell it
+// can reach and the next wall.  This is an upper bound on the cells the
+// accessibility search can label.
+void Solver::markReachable(int cell, std::vector<char> &reachable) const {
+  static const int dr[4] = { -1, 1, 0, 0 };
+  static const int dc[4] = { 0, 0, 1, -1 };
+  int cols = board->getCols();
+  std::vector<int> queue(1,cell);
+  reachable[cell] = 1;
+  for (unsigned int q = 0; q < queue.size(); q++) {
+    int from = queue[q];
+    for (int d = NORTH; d <= WEST; d++) {
+      int stop = board->slideStop(from,d);
+      int r = from / cols;
+      int c = from % cols;
+      while (r*cols + c != stop) {
+        r += dr[d];
+        c += dc[d];
+        if (!reachable[r*cols + c]) {
+          reachable[r*cols + c] = 1;
+          queue.push_back(r*cols + c);
+        }
+      }
+    }
+  }
+}
+
+// The fewest moves for any robot (and optionally for each robot) to
+// stop in each cell, from a breadth first search over the robot
+// configurations.  Unlike solving, the search does not stop at the
+// goal; instead it stops as soon as every cell that could possibly be
+// reached has a label, which usually happens long before the whole
+// space of configurations has been explored.  Without the per robot
+// maps every robot is interchangeable, which shrinks the space further.
+void Solver::solveAccessibility() {
+  int rows = board->getRows();
+  int cols = board->getCols();
+  int limit = moveLimit();
+  bool per_robot = options.per_robot;
+  std::vector<Position> start = board->getRobotPositions();
+
+  Grid<int> &viz = result->accessibility;
+  viz = Grid<int>(rows+1,cols+1,-1);
+  std::vector<Grid<int> > &robot_viz = result->robot_accessibility;
+  if (per_robot) robot_viz.assign(num_robots,viz);
+
+  // the number of labels still missing (cells for the combined map,
+  // plus robot/cell pairs for the per robot maps)
+  long long remaining = 0;
+  std::vector<char> any_reachable(rows*cols,0);
+  std::vector<std::vector<char> > robot_reachable(num_robots);
+  for (int i = 0; i < num_robots; i++) {
+    std::vector<char> &reachable = robot_reachable[i];
+    reachable.assign(rows*cols,0);
+    markReachable((start[i].row-1)*cols + start[i].col-1, reachable);
+    for (int cell = 0; cell < rows*cols; cell++) {
+      if (!reachable[cell]) continue;
+      if (per_robot) remaining++;
+      if (!any_reachable[cell]) remaining++;
+      any_reachable[cell] = 1;
+    }
+  }
+  for (int i = 0; i < num_robots; i++) {
+    viz[start[i].row][start[i].col] = 0;
+    remaining--;
+    if (per_robot) {
+      robot_viz[i][start[i].row][start[i].col] = 0;
+      remaining--;
+    }
+  }
+
+  codec = StateCodec(rows,cols,num_robots,-1,!per_robot);
+  int words = codec.words();
+  std::vector<uint64_t> key(words);
+  depths.reset(words,1);
+  StateTable &table = depths.shard(0);
+  codec.encode(start,&key[0]);
+  table.insert(&key[0],0);
+
+  frontier.assign(key.begin(),key.end());
+  std::vector<Position> pos;
+  Occupancy occ;
+
+  for (int depth = 1; depth <= limit && !frontier.empty() && remaining > 0; depth++) {
+    std::chrono::steady_clock::time_point layer_start = std::chrono::steady_clock::now();
+    long long states = 0;
+    long long generated = 0;
+    next_frontier.clear();
+    for (unsigned int s = 0; s < frontier.size() && remaining > 0; s += words) {
+      // past the memory budget, the cells not labeled yet stay unknown
+      if ((s/words) % 65536 == 0 && overMemoryLimit()) break;
+      states++;
+      result->expanded++;
+      codec.decode(&frontier[s],pos);
+      if (board->hasBitboards()) board->fillOccupancy(pos,occ);
+      for (int i = 0; i < num_robots; i++) {
+        Position from = pos[i];
+        for (int d = NORTH; d <= WEST; d++) {
+          if (!step(pos,occ,i,d)) continue;
+          generated++;
+          int &v = viz[pos[i].row][pos[i].col];
+          if (v == -1) {
+            v = depth;
+            remaining--;
+          }
+          if (per_robot) {
+            int &rv = robot_viz[i][pos[i].row][pos[i].col];
+            if (rv == -1) {
+              rv = depth;
+              remaining--;
+            }
+          }
+          codec.encode(pos,&key[0]);
+          if (table.insert(&key[0],depth)) {
+            next_frontier.insert(next_frontier.end(),key.begin(),key.end());
+          }
+          pos[i] = from;
+        }
+      }
+    }
+    countLayer(secondsSince(layer_start), states, generated, next_frontier.size() / words);
+    if (out_of_memory) break;
+    frontier.swap(next_frontier);
+  }
+  result->at_limit = (remaining > 0 && !frontier.empty() && !out_of_memory);
+  countTable(table.probeCount(),table.size(),table.slots());
+  if (!out_of_memory) return;
+
+  // the cells that could still be reached but have no label are unknown
+  // rather than unreached
+  result->out_of_memory = true;
+  for (int cell = 0; cell < rows*cols; cell++) {
+    int r = cell / cols + 1;
+    int c = cell % cols + 1;
+    if (any_reachable[cell] && viz[r][c] == -1) viz[r][c] = SolverResult::UNKNOWN;
+    for (int i = 0; per_robot && i < num_robots; i++) {
+      if (robot_reachable[i][cell] && robot_viz[i][r][c] == -1) {
+        robot_viz[i][r][c] = SolverResult::UNKNOWN;
+      }
+    }
+  }
+}
@@ -0,0 +1,318 @@
+#ifndef __SOLVER_H__
+#define __SOLVER_H__
+
+#include <vector>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "board.h"
+#include "state.h"
+#include "cache.h"
+#include "pdb.h"
+#include "pool.h"
+
+
+// ==================================================================
+// ==================================================================
+// What to search for
+
+class SolverOptions {
+public:
+  SolverOptions() : max_moves(-1), all_solutions(false), count_solutions(false),
+                    accessibility(false),
+                    per_robot(false), ida(false), bidirectional(false), threads(1),
+                    mem_limit(4LL << 30), cache_size(64LL << 20) {}
+
+  // the most moves a solution may use (-1 for no cap, other than the
+  // Solver::MAX_MOVES the search tables can count)
+  int max_moves;
+  // find every solution that uses the fewest moves, not just the first
+  bool all_solutions;
+  // count the solutions that use the fewest moves (without listing them)
+  bool count_solutions;
+  // if set, every solution found with all_solutions is passed here, in
+  // order and along with how many there are in all, instead of being
+  // stored in SolverResult::paths
+  std::function<void(const MovePath &path, unsigned long long total)> on_solution;
+  // compute the accessibility map instead of solving the puzzle
+  bool accessibility;
+  // along with the accessibility map, compute one for each robot
+  bool per_robot;
+  // use iterative deepening A* instead of the breadth first search
+  bool ida;
+  // search from both ends at once when a particular robot must reach
+  // the goal (and doesn't start there)
+  bool bidirectional;
+  // the number of threads that expand each layer of the breadth first
+  // search for a solution
+  int threads;
+  // the bytes the search tables and layers may use; a breadth first
+  // search that would need more falls back to iterative deepening
+  long long mem_limit;
+  // if set, a directory of on-disk caches (one file per layout) of the
+  // moves from configurations to the goal, shared with earlier runs
+  std::string cache_dir;
+  // the most bytes a new cache file may take
+  long long cache_size;
+  // if set, a pattern database file (made by pdbgen) for the layout,
+  // which tightens the estimates of iterative deepening.  It is only
+  // used by iterative deepening on a puzzle with a goal robot, and is
+  // ignored if it is for a different layout (SolverResult::pdb_used
+  // tells whether it was used).
+  std::string pdb_file;
+  // if set, the goal distances of the board (see computeGoalDistances),
+  // kept from an earlier solve on the same walls and goal so they aren't
+  // computed again
+  std::shared_ptr<const std::vector<int> > goal_distances;
+};
+
+
+// ==================================================================
+// ==================================================================
+// Counters of the work a search did, to see where the time goes.  The
+// hot loops keep their own counts (one set per thread) and add them in
+// here once per layer, so keeping them costs next to nothing.
+
+class SolverStats {
+public:
+  SolverStats() : cell_bits(0), key_words(0), generated(0), duplicates(0), slides(0),
+                  table_size(0), table_slots(0), peak_frontier(0) {}
+
+  // the bits of each robot's cell in a packed configuration, and the
+  // 64 bit words of a whole configuration (see StateCodec)
+  int cell_bits;
+  int key_words;
+
+  // configurations made by moving a robot, and how many of them had
+  // been reached before
+  long long generated;
+  long long duplicates;
+  // robot moves looked up (including the ones that went nowhere)
+  long long slides;
+  // the lookups into the search tables, and the slots they looked at
+  ProbeCount probes;
+  // the configurations in the search tables at the end, and the slots
+  // they had (table_size / table_slots is the load factor)
+  long long table_size;
+  long long table_slots;
+  // the most configurations in one layer of a breadth first search
+  long long peak_frontier;
+  // the seconds spent on each layer of a breadth first search (both
+  // directions, in the order they were grown), or on each iteration of
+  // iterative deepening
+  std::vector<double> depth_seconds;
+};
+
+
+// ==================================================================
+// ==================================================================
+// What a search found
+
+class SolverResult {
+public:
+  SolverResult() : moves(-1), at_limit(false), out_of_memory(false), solutions(0),
+                   expanded(0), pdb_used(false) {}
+
+  // an accessibility map entry for a cell that could not be labeled
+  // because the search ran out of memory first
+  static const int UNKNOWN = -2;
+
+  // the number of moves in the optimal solution (-1 if none was found)
+  int moves;
+  // whether the search stopped at the move limit with configurations
+  // still left to explore, so with no solution found one may yet exist
+  // that uses more moves
+  bool at_limit;
+  // whether the accessibility search stopped at the memory budget, so
+  // the maps are incomplete (the cells it could not tell about are
+  // UNKNOWN)
+  bool out_of_memory;
+  // the number of optimal solutions (just 1 unless all of them were
+  // requested or counted)
+  unsigned long long solutions;
+  // the optimal move sequences, the lexicographically smallest first
+  // (just that one unless all the solutions were requested, and none if
+  // they were passed to SolverOptions::on_solution)
+  std::vector<MovePath> paths;
+  // fewest moves for any robot to stop in each cell (-1 if unreached,
+  // UNKNOWN if not found out), indexed by [row][col] starting from 1
+  // (only if it was requested)
+  Grid<int> accessibility;
+  // the same for each robot, indexed by [robot id][row][col]
+  std::vector<Grid<int> > robot_accessibility;
+  // the number of configurations the search expanded
+  long long expanded;
+  // whether the pattern database of SolverOptions::pdb_file was opened
+  // and used for the estimates
+  bool pdb_used;
+  // what else the search did
+  SolverStats stats;
+};
+
+
+// ==================================================================
+// ==================================================================
+// The fewest moves a single robot needs from each cell (numbered row
+// major from 0) to the goal of board, which must have its slide stops
+// computed: -1 if it can't get there, and never more than the moves of
+// any solution with that robot as the goal robot
+
+void computeGoalDistances(const Board &board, std::vector<int> &distances);
+
+
+// ==================================================================
+// ==================================================================
+// A partial configuration, for the backward half of the bidirectional
+// search on boards of up to 16x16 cells: the goal robot's cell, cells
+// that other robots are in and cells that no robot is in, with nothing
+// said about the rest of the board.  Every configuration that fits it
+// is depth moves from a solution, or fewer.
+
+class PartialConfiguration {
+public:
+  // the goal robot's cell and the cells of the other robots placed
+  // (packed as in solver.cpp)
+  uint64_t placed;
+  // bit c is set if no robot may be in cell c (numbered row major from 0)
+  uint64_t free[4];
+  int depth;
+};
+
+
+// ==================================================================
+// ==================================================================
+// Searches for the fewest moves that bring a robot to the goal.  The
+// board is only read, and all the scratch state (hash tables, search
+// layers, ...) belongs to the Solver and keeps its memory from one
+// solve to the next.  A Solver can only run one solve at a time, but
+// any number of Solvers can work on the same Board at once.
+
+class Solver {
+public:
+  // the most moves any search goes to (iterative deepening stores twice
+  // the moves, plus one, in a StateTable)
+  static const int MAX_MOVES = (StateTable::MAX_DEPTH - 1) / 2;
+
+  Solver() : board(NULL), result(NULL), expand_serial(NULL), expand_piece(NULL),
+             meet_depth(0), streaming(false),
+             cache_bound(-1), cache_stored(false), out_of_memory(false),
+             goal_distances(NULL), transposition_cap(0), ida_found(0) {}
+
+  // the board must have its slide stops computed
+  SolverResult solve(const Board &board, const SolverOptions &options);
+
+private:
+  // the search algorithms
+  void solveBFS();
+  void solveIDA(int first_bound);
+  void solveAccessibility();
+  void solveBidirectional();
+
+  // helper functions
+  int moveLimit() const;
+  bool overMemoryLimit();
+  void releaseTables();
+  bool isSolved(const std::vector<Position> &pos) const;
+  bool isSolvedKey(const uint64_t *key) const;
+  bool step(std::vector<Position> &pos, const Occupancy &occ, int i, int direction) const;
+  long long expandLayer(int depth);
+  long long expandLayerSerial(int depth);
+  template <int ROWS, int COLS, int ROBOTS> long long expandLayerFixed(int depth);
+  long long expandPieceSerial(unsigned int first, unsigned int last, int piece);
+  template <int ROWS, int COLS, int ROBOTS>
+  long long expandPieceFixed(unsigned int first, unsigned int last, int piece);
+  void chooseLayerExpansion();
+  void collectSolutions(const std::vector<Position> &start);
+  bool onPath(const std::vector<Position> &next, int depth, uint64_t *key) const;
+  bool findPaths(std::vector<Position> &pos, int depth, MovePath &path);
+  uint64_t countPaths(std::vector<Position> &pos, int depth);
+  void recordSolution(const MovePath &path);
+  int cachedLength(const uint64_t *key, int depth) const;
+  bool addPattern(const PartialConfiguration &pattern);
+  int backwardDistance(const uint64_t *key) const;
+  int meetingDistance() const;
+  void expandForward(int depth);
+  void expandBackward(int depth, unsigned int first);
+  void prepareGoalDistances();
+  int goalDistance(const std::vector<Position> &pos) const;
+  int estimateMoves(const std::vector<Position> &pos, uint64_t *key) const;
+  int idaSearch(std::vector<Position> &pos, int moves, int bound,
+                int last_robot, int last_direction, MovePath &path);
+  void markReachable(int cell, std::vector<char> &reachable) const;
+  void countLayer(double seconds, long long states, long long generated, long long added);
+  void countTable(const ProbeCount &probes, long long size, long long slots);
+
+  // the puzzle, options and results of the current solve
+  const Board *board;
+  SolverOptions options;
+  SolverResult *result;
+  int num_robots;
+  Position goal;
+  int goal_robot;
+
+  // SCRATCH STATE
+  StateCodec codec;
+  // the single threaded layer expansion of the breadth first search,
+  // specialized for the board of the current solve if it is one of the
+  // common sizes
+  long long (Solver::*expand_serial)(int depth);
+  // the same for the first phase of expandLayer, on one piece of a block
+  long long (Solver::*expand_piece)(unsigned int first, unsigned int last, int piece);
+  // the depth at which each configuration was first reached (split
+  // into shards so that each thread can fill its own)
+  ShardedStateTable depths;
+  // the partial configurations of the backward half of the
+  // bidirectional search, layer by layer, and the ones with each
+  // placement of robots (see backwardDistance)
+  std::vector<PartialConfiguration> patterns;
+  std::unordered_map<uint64_t,std::vector<unsigned int> > pattern_index;
+  // findPaths checks the layers before this depth against depths, and
+  // the later ones against the backward search
+  int meet_depth;
+  // configurations that findPaths found don't lead to a solution
+  StateTable dead;
+  // the number of optimal solutions from each configuration countPaths
+  // has visited
+  CountTable counts;
+  // the packed configuration at each depth of the move sequence
+  // findPaths and countPaths are following
+  std::vector<uint64_t> path_keys;
+  // set while solutions are being passed to SolverOptions::on_solution
+  bool streaming;
+  // the cache of the current layout (if any), and the fewest moves of
+  // a solution through a configuration found in it (-1 if none was)
+  DistanceCache cache;
+  int cache_bound;
+  // set once the first solution has been stored in the cache
+  bool cache_stored;
+  // the current and next layers of the breadth first search, as flat
+  // arrays of packed configurations
+  std::vector<uint64_t> frontier;
+  std::vector<uint64_t> next_frontier;
+  // the threads that expand the layers with expandLayer (started by
+  // the first solve that needs them), the buckets its pieces sort their
+  // configurations into and the new configurations of each shard
+  std::unique_ptr<WorkStealingPool> pool;
+  std::vector<std::vector<uint64_t> > buckets;
+  std::vector<std::vector<uint64_t> > found;
+  // set once a breadth first search has run out of memory
+  bool out_of_memory;
+  // the fewest moves from each cell to the goal, ignoring the other
+  // robots (-1 if the goal can't be reached from there): the ones from
+  // the options, or else own_goal_distances
+  const int *goal_distances;
+  std::vector<int> own_goal_distances;
+  // the pattern database of the current layout, if there is one
+  PatternDatabase pdb;
+  // the configurations iterative deepening has already searched from in
+  // this iteration, with 2 * the moves made to reach them, plus 1 if a
+  // solution was found from there (at most transposition_cap of them)
+  StateTable transpositions;
+  unsigned int transposition_cap;
+  // the packed configuration at each depth of the current move sequence
+  std::vector<uint64_t> ida_keys;
+  // the solutions found by the current iterative deepening pass
+  unsigned long long ida_found;
+};
+
+#endif
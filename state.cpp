@@ -0,0 +1,316 @@
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include "board.h"
+#include "state.h"
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the StateCodec class
+
+StateCodec::StateCodec(int r, int c, int n, int g, bool i) {
+  rows = r;
+  cols = c;
+  num_robots = n;
+  goal_robot = g;
+  interchangeable = i;
+  // one byte per robot is enough for up to 256 cells, and two for up
+  // to 65536
+  long long cells = (long long)rows*cols;
+  bits = (cells <= 256) ? 8 : (cells <= 65536) ? 16 : 32;
+  per_word = 64 / bits;
+  num_words = (num_robots + per_word - 1) / per_word;
+  if (num_words == 0) num_words = 1;
+}
+
+void StateCodec::encode(const std::vector<Position> &pos, uint64_t *key) const {
+  assert ((int)pos.size() == num_robots);
+  // robot names are capital letters, so there are at most 26 robots
+  unsigned int cells[Board::MAX_ROBOTS];
+  int n = 0;
+  if (!interchangeable) {
+    for (int i = 0; i < num_robots; i++) {
+      cells[n++] = (pos[i].row-1)*cols + pos[i].col-1;
+    }
+  } else {
+    if (goal_robot != -1) {
+      cells[n++] = (pos[goal_robot].row-1)*cols + pos[goal_robot].col-1;
+    }
+    int first = n;
+    for (int i = 0; i < num_robots; i++) {
+      if (i == goal_robot) continue;
+      // insertion sort of the interchangeable robots
+      unsigned int cell = (pos[i].row-1)*cols + pos[i].col-1;
+      int j = n++;
+      while (j > first && cells[j-1] > cell) {
+        cells[j] = cells[j-1];
+        j--;
+      }
+      cells[j] = cell;
+    }
+  }
+  for (int w = 0; w < num_words; w++) key[w] = 0;
+  for (int i = 0; i < n; i++) {
+    key[i / per_word] |= uint64_t(cells[i]) << ((i % per_word) * bits);
+  }
+}
+
+void StateCodec::decode(const uint64_t *key, std::vector<Position> &pos) const {
+  pos.resize(num_robots);
+  uint64_t cell_mask = (uint64_t(1) << bits) - 1;
+  // the goal robot (if any) is in the first slot, the others follow
+  int g = interchangeable ? goal_robot : -1;
+  int robot = (g != -1) ? g : 0;
+  for (int i = 0; i < num_robots; i++) {
+    unsigned int cell = (key[i / per_word] >> ((i % per_word) * bits)) & cell_mask;
+    pos[robot].row = cell / cols + 1;
+    pos[robot].col = cell % cols + 1;
+    robot = (i == 0 && g != -1) ? 0 : robot+1;
+    if (robot == g) robot++;
+  }
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the StateTable class
+
+// a 64 bit mixing function (the finalizer from MurmurHash3)
+static inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t hashState(const uint64_t *key, int words) {
+  uint64_t h = 0;
+  for (int w = 0; w < words; w++) {
+    h = mix(h ^ key[w]);
+  }
+  return h;
+}
+
+StateTable::StateTable(int words) {
+  count = 0;
+  reset(words);
+}
+
+void StateTable::reset(int words) {
+  // the memory is kept for the next use, but if the table was mostly
+  // empty last time only the part that is likely to be needed is
+  // cleared (it grows back without reallocating)
+  unsigned int size = 1024;
+  while (size < 4*count) size *= 2;
+  if (depths.empty() || size < depths.size()) {
+    depths.resize(size);
+  }
+  num_words = words;
+  count = 0;
+  mask = depths.size() - 1;
+  keys.resize(depths.size() * num_words);
+  std::fill(depths.begin(), depths.end(), 0);
+  inserts = ProbeCount();
+}
+
+// the slot holding key, or the empty slot where it belongs
+// (adding the number of slots looked at to probes)
+unsigned int StateTable::probe(const uint64_t *key, long long &probes) const {
+  unsigned int i = hashState(key,num_words) & mask;
+  probes++;
+  while (depths[i] != 0 &&
+         memcmp(&keys[i*num_words], key, num_words*sizeof(uint64_t)) != 0) {
+    i = (i+1) & mask;
+    probes++;
+  }
+  return i;
+}
+
+int StateTable::find(const uint64_t *key) const {
+  long long probes = 0;
+  return int(depths[probe(key,probes)]) - 1;
+}
+
+int StateTable::find(const uint64_t *key, ProbeCount &count) const {
+  count.lookups++;
+  return int(depths[probe(key,count.probes)]) - 1;
+}
+
+bool StateTable::insert(const uint64_t *key, int depth) {
+  assert (depth >= 0 && depth <= MAX_DEPTH);
+  inserts.lookups++;
+  unsigned int i = probe(key,inserts.probes);
+  if (depths[i] != 0) return false;
+  memcpy(&keys[i*num_words], key, num_words*sizeof(uint64_t));
+  depths[i] = depth+1;
+  count++;
+  // keep the table at most 2/3 full so the probe sequences stay short
+  if (3*count > 2*depths.size()) grow();
+  return true;
+}
+
+void StateTable::set(const uint64_t *key, int depth) {
+  assert (depth >= 0 && depth <= MAX_DEPTH);
+  inserts.lookups++;
+  unsigned int i = probe(key,inserts.probes);
+  if (depths[i] == 0) {
+    memcpy(&keys[i*num_words], key, num_words*sizeof(uint64_t));
+    count++;
+  }
+  depths[i] = depth+1;
+  if (3*count > 2*depths.size()) grow();
+}
+
+size_t StateTable::memory() const {
+  return keys.capacity()*sizeof(uint64_t) + depths.capacity()*sizeof(unsigned short);
+}
+
+// double the number of slots and re-insert everything
+void StateTable::grow() {
+  std::vector<uint64_t> old_keys;
+  std::vector<unsigned short> old_depths;
+  old_keys.swap(keys);
+  old_depths.swap(depths);
+  depths.assign(old_depths.size()*2, 0);
+  keys.resize(depths.size() * num_words);
+  mask = depths.size() - 1;
+  // moving the keys isn't counted as lookups
+  long long probes = 0;
+  for (unsigned int i = 0; i < old_depths.size(); i++) {
+    if (old_depths[i] == 0) continue;
+    unsigned int j = probe(&old_keys[i*num_words],probes);
+    memcpy(&keys[j*num_words], &old_keys[i*num_words], num_words*sizeof(uint64_t));
+    depths[j] = old_depths[i];
+  }
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the CountTable class
+
+CountTable::CountTable(int words) {
+  count = 0;
+  reset(words);
+}
+
+void CountTable::reset(int words) {
+  // like StateTable::reset, only clear what is likely to be needed
+  unsigned int size = 1024;
+  while (size < 4*count) size *= 2;
+  if (used.empty() || size < used.size()) {
+    used.resize(size);
+  }
+  num_words = words;
+  count = 0;
+  mask = used.size() - 1;
+  keys.resize(used.size() * num_words);
+  counts.resize(used.size());
+  std::fill(used.begin(), used.end(), 0);
+}
+
+unsigned int CountTable::probe(const uint64_t *key) const {
+  unsigned int i = hashState(key,num_words) & mask;
+  while (used[i] &&
+         memcmp(&keys[i*num_words], key, num_words*sizeof(uint64_t)) != 0) {
+    i = (i+1) & mask;
+  }
+  return i;
+}
+
+bool CountTable::find(const uint64_t *key, uint64_t &n) const {
+  unsigned int i = probe(key);
+  if (!used[i]) return false;
+  n = counts[i];
+  return true;
+}
+
+void CountTable::insert(const uint64_t *key, uint64_t n) {
+  unsigned int i = probe(key);
+  assert (!used[i]);
+  memcpy(&keys[i*num_words], key, num_words*sizeof(uint64_t));
+  counts[i] = n;
+  used[i] = 1;
+  count++;
+  if (3*count > 2*used.size()) grow();
+}
+
+void CountTable::grow() {
+  std::vector<uint64_t> old_keys;
+  std::vector<uint64_t> old_counts;
+  std::vector<char> old_used;
+  old_keys.swap(keys);
+  old_counts.swap(counts);
+  old_used.swap(used);
+  used.assign(old_used.size()*2, 0);
+  keys.resize(used.size() * num_words);
+  counts.resize(used.size());
+  mask = used.size() - 1;
+  for (unsigned int i = 0; i < old_used.size(); i++) {
+    if (!old_used[i]) continue;
+    unsigned int j = probe(&old_keys[i*num_words]);
+    memcpy(&keys[j*num_words], &old_keys[i*num_words], num_words*sizeof(uint64_t));
+    counts[j] = old_counts[i];
+    used[j] = 1;
+  }
+}
+
+
+// ==================================================================
+// ==================================================================
+// Implementation of the ShardedStateTable class
+
+ShardedStateTable::ShardedStateTable(int words, int shards) {
+  reset(words,shards);
+}
+
+void ShardedStateTable::reset(int words, int shards) {
+  assert (shards >= 1);
+  num_words = words;
+  tables.resize(shards);
+  for (int s = 0; s < shards; s++) {
+    tables[s].reset(words);
+  }
+}
+
+// the shard is picked with the high bits of the hash, the tables use
+// the low bits to pick the slot
+int ShardedStateTable::shardOf(const uint64_t *key) const {
+  if (tables.size() == 1) return 0;
+  return (hashState(key,num_words) >> 40) % tables.size();
+}
+
+unsigned int ShardedStateTable::size() const {
+  unsigned int total = 0;
+  for (unsigned int s = 0; s < tables.size(); s++) {
+    total += tables[s].size();
+  }
+  return total;
+}
+
+unsigned int ShardedStateTable::slots() const {
+  unsigned int total = 0;
+  for (unsigned int s = 0; s < tables.size(); s++) {
+    total += tables[s].slots();
+  }
+  return total;
+}
+
+size_t ShardedStateTable::memory() const {
+  size_t total = 0;
+  for (unsigned int s = 0; s < tables.size(); s++) {
+    total += tables[s].memory();
+  }
+  return total;
+}
+
+ProbeCount ShardedStateTable::probeCount() const {
+  ProbeCount total;
+  for (unsigned int s = 0; s < tables.size(); s++) {
+    total.add(tables[s].probeCount());
+  }
+  return total;
+}
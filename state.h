@@ -0,0 +1,193 @@
+#ifndef __STATE_H__
+#define __STATE_H__
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+class Position;
+
+
+// ==================================================================
+// ==================================================================
+// Packs a whole robot configuration into one or more 64 bit words.
+// Each robot is stored as a cell id (row major, starting from 0), the
+// narrowest of 8, 16 or 32 bits that holds every cell of the board:
+// one byte per robot on boards of up to 16x16 cells (so the usual 4 or
+// 5 robots fit in a single word), two bytes up to 256x256 cells and
+// four bytes on bigger boards.  The keys, and so the tables of the
+// searches, take memory in proportion to the board size that way.
+//
+// Robots that are interchangeable (every robot other than the goal
+// robot, or all of them if any robot may reach the goal) are stored in
+// sorted order, so configurations that only differ by swapping those
+// robots share one key.  When there is a goal robot it is always
+// stored in the first slot.  A codec made with interchangeable set to
+// false keeps every robot in its own slot instead.
+
+class StateCodec {
+public:
+  StateCodec(int rows=1, int cols=1, int num_robots=0, int goal_robot=-1,
+             bool interchangeable=true);
+
+  int words() const { return num_words; }
+  // the bits each robot takes
+  int cellBits() const { return bits; }
+
+  // pack the robot positions (indexed by robot id) into key
+  void encode(const std::vector<Position> &pos, uint64_t *key) const;
+  // unpack key into positions indexed by robot id (the interchangeable
+  // robots come back in sorted order, not necessarily with the ids
+  // they had when the key was made)
+  void decode(const uint64_t *key, std::vector<Position> &pos) const;
+  // the cell id in slot i of key (slot 0 holds the goal robot, if any)
+  unsigned int cell(const uint64_t *key, int i) const {
+    return (key[i / per_word] >> ((i % per_word) * bits)) & ((uint64_t(1) << bits) - 1);
+  }
+
+private:
+  int rows, cols;
+  int num_robots;
+  int goal_robot;
+  bool interchangeable;
+  int bits;
+  int per_word;
+  int num_words;
+};
+
+
+// ==================================================================
+// ==================================================================
+// A count of hash table lookups and of the slots they looked at (the
+// average probe sequence length is probes / lookups).  The tables count
+// their own inserts, while lookups with find are counted in one kept by
+// the caller, so that several threads can each keep their own.
+
+class ProbeCount {
+public:
+  ProbeCount() : lookups(0), probes(0) {}
+  void add(const ProbeCount &other) { lookups += other.lookups; probes += other.probes; }
+  long long lookups;
+  long long probes;
+};
+
+
+// ==================================================================
+// ==================================================================
+// An open addressing (linear probing) hash table from packed
+// configurations to the depth at which they were first reached.  The
+// keys are stored back to back in one flat array, so a configuration
+// costs words()*8 + 2 bytes plus the unused slots.
+
+class StateTable {
+public:
+  // the deepest depth a table can hold
+  static const int MAX_DEPTH = 65534;
+
+  StateTable(int words=1);
+
+  // empty the table (keeping the storage) and set the key width
+  void reset(int words);
+
+  // the depth stored for key, or -1 if key is not in the table (the
+  // second version also adds the lookup to count)
+  int find(const uint64_t *key) const;
+  int find(const uint64_t *key, ProbeCount &count) const;
+  // add key with the given depth, returns false if it was already there
+  bool insert(const uint64_t *key, int depth);
+  // add key, or change the depth stored for it
+  void set(const uint64_t *key, int depth);
+
+  unsigned int size() const { return count; }
+  unsigned int slots() const { return depths.size(); }
+  // the bytes of storage the table holds on to
+  size_t memory() const;
+  // the lookups of the inserts and sets since the last reset
+  const ProbeCount& probeCount() const { return inserts; }
+
+private:
+  unsigned int probe(const uint64_t *key, long long &probes) const;
+  void grow();
+
+  int num_words;
+  unsigned int count;
+  unsigned int mask;
+  ProbeCount inserts;
+  std::vector<uint64_t> keys;
+  // depth+1 for each slot, 0 marks an empty slot
+  std::vector<unsigned short> depths;
+};
+
+
+
+// ==================================================================
+// ==================================================================
+// The same kind of table as StateTable, but from packed configurations
+// to 64 bit counts (used to count the optimal solutions through each
+// configuration).
+
+class CountTable {
+public:
+  CountTable(int words=1);
+
+  // empty the table (keeping the storage) and set the key width
+  void reset(int words);
+
+  // look up key, returns false if it is not in the table
+  bool find(const uint64_t *key, uint64_t &n) const;
+  // add key (which must not be in the table yet) with count n
+  void insert(const uint64_t *key, uint64_t n);
+
+  unsigned int size() const { return count; }
+
+private:
+  unsigned int probe(const uint64_t *key) const;
+  void grow();
+
+  int num_words;
+  unsigned int count;
+  unsigned int mask;
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> counts;
+  // 1 for each slot in use
+  std::vector<char> used;
+};
+
+// ==================================================================
+// ==================================================================
+// A StateTable split into independent shards by the hash of the key,
+// so that several threads can each fill their own shards at the same
+// time without locking.  Looking keys up is safe from any number of
+// threads as long as no shard is being modified.
+
+class ShardedStateTable {
+public:
+  ShardedStateTable(int words=1, int shards=1);
+
+  // empty every shard (keeping the storage)
+  void reset(int words, int shards);
+
+  int numShards() const { return tables.size(); }
+  int shardOf(const uint64_t *key) const;
+  StateTable& shard(int s) { return tables[s]; }
+
+  int find(const uint64_t *key) const { return tables[shardOf(key)].find(key); }
+  int find(const uint64_t *key, ProbeCount &count) const {
+    return tables[shardOf(key)].find(key,count);
+  }
+  unsigned int size() const;
+  unsigned int slots() const;
+  size_t memory() const;
+  // the lookups of the inserts into all the shards
+  ProbeCount probeCount() const;
+
+private:
+  int num_words;
+  std::vector<StateTable> tables;
+};
+
+
+// the hash used to place packed configurations in the tables
+uint64_t hashState(const uint64_t *key, int words);
+
+#endif